@@ -0,0 +1,94 @@
+#!/usr/bin/env bash
+#
+# Copyright (c) 2020 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+#
+# Run a room of simulated GUS badges in BabbleSim and print the collector
+# results, one CSV line per report round.
+#
+#   bsim/run_sweep.sh [-o overlay.conf] [-r room_m] [-e exponent] \
+#                     [-s sim_s] [-x seed] badges...
+#
+#   bsim/run_sweep.sh 10 50 200
+#   bsim/run_sweep.sh -o overlay-sweep.conf 50
+#
+# For every badge count, the firmware is built for nrf52_bsim with
+# CONFIG_GUS_BSIM_BADGES set, the badges are placed at random in a square
+# room, and the path loss between every pair of badges is written to a
+# multiatt channel file using a log-distance model:
+#
+#   loss = 40 dB + 10 * exponent * log10(distance / 1 m)
+#
+# Needs BSIM_OUT_PATH and BSIM_COMPONENTS_PATH, as for the Zephyr
+# BabbleSim tests, and west on the path.
+
+set -e
+
+room=10
+exponent=2.5
+sim_s=120
+seed=1
+overlay=
+
+while getopts "o:r:e:s:x:" opt; do
+	case $opt in
+	o) overlay=$(realpath "$OPTARG") ;;
+	r) room=$OPTARG ;;
+	e) exponent=$OPTARG ;;
+	s) sim_s=$OPTARG ;;
+	x) seed=$OPTARG ;;
+	*) exit 1 ;;
+	esac
+done
+shift $((OPTIND - 1))
+
+: "${BSIM_OUT_PATH:?BSIM_OUT_PATH is not set}"
+
+app_dir=$(realpath "$(dirname "$0")/..")
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+
+echo "badges,round,time_ms,replies,missing,contacts,sent,retries,send_err"
+
+for badges in "${@:-10}"; do
+	build_dir=$app_dir/build_bsim_$badges
+	devices=$((badges + 1))
+	sim_id=gus_sweep_${badges}_$$
+	att_file=$work_dir/att_$badges.txt
+
+	west build -s "$app_dir" -b nrf52_bsim -d "$build_dir" -- \
+		-DCONFIG_GUS_BSIM_BADGES="$badges" \
+		${overlay:+-DOVERLAY_CONFIG="$overlay"} > "$work_dir/build.log"
+
+	python3 - "$devices" "$room" "$exponent" "$seed" > "$att_file" <<-EOF
+		import math, random, sys
+		n, room, exp, seed = int(sys.argv[1]), float(sys.argv[2]), \
+		    float(sys.argv[3]), int(sys.argv[4])
+		random.seed(seed)
+		pos = [(random.uniform(0, room), random.uniform(0, room))
+		       for _ in range(n)]
+		for i in range(n):
+		    for j in range(n):
+		        if i != j:
+		            d = max(math.dist(pos[i], pos[j]), 0.1)
+		            loss = 40 + 10 * exp * math.log10(d)
+		            print(f"{i} {j} : {loss:.1f}")
+	EOF
+
+	for ((dev = 0; dev < devices; dev++)); do
+		"$build_dir/zephyr/zephyr.exe" -s="$sim_id" -d="$dev" \
+			-RealEncryption=1 > "$work_dir/dev_$dev.log" 2>&1 &
+	done
+
+	(cd "$BSIM_OUT_PATH/bin" && ./bs_2G4_phy_v1 -s="$sim_id" \
+		-D="$devices" -sim_length=$((sim_s * 1000000)) \
+		-channel=multiatt -argschannel -at=90 -file="$att_file" \
+		> "$work_dir/phy.log" 2>&1)
+	wait
+
+	grep -h "gus_bsim: .*failed" "$work_dir"/dev_*.log >&2 || true
+
+	sed -n "s/.*gus_bsim: round \([0-9]*\) badges \([0-9]*\) time_ms \([0-9]*\) replies \([0-9]*\) missing \([0-9]*\) contacts \([0-9]*\) sent \([0-9]*\) retries \([0-9]*\) send_err \([0-9]*\).*/\2,\1,\3,\4,\5,\6,\7,\8,\9/p" \
+		"$work_dir/dev_0.log"
+done
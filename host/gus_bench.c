@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/////////////////////////////////////////////////////////////////////////
+// Proximity core microbenchmark.
+// Times, for a few neighbor counts up to the table size:
+//   sample - gus_neighbors_add() of a sample from a random known neighbor
+//   report - gus_neighbors_top() plus gus_core_compact_encode()
+//   round  - gus_neighbors_new_round() on a full set of neighbors
+// and prints one line per neighbor count.  With limits given on the
+// command line, it exits with 1 if a sample or a report costs more, so a
+// script can catch cost regressions.
+/////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gus_core.h"
+#include "gus_neighbors.h"
+
+#define TABLE_SIZE      CONFIG_GUS_NEIGHBOR_TABLE_SIZE
+#define SAMPLES         2000000
+#define REPORTS         500000
+#define ROUNDS          20000
+#define FIRST_ADDR      0x0002
+#define OWN_ADDR        0x0001
+
+static uint32_t rng_state = 0x47555321;
+
+static volatile size_t sink;
+
+static uint32_t rng(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static int8_t random_rssi(void)
+{
+	return -40 - (int8_t)(rng() % 60);
+}
+
+static void fill(int neighbors)
+{
+	gus_neighbors_reset();
+	for (int i = 0; i < neighbors; ++i) {
+		(void)gus_neighbors_add(FIRST_ADDR + i, random_rssi(), 0);
+	}
+}
+
+static double bench_samples(int neighbors)
+{
+	fill(neighbors);
+
+	uint64_t start = now_ns();
+
+	for (uint32_t i = 0; i < SAMPLES; ++i) {
+		uint16_t addr = FIRST_ADDR + rng() % neighbors;
+
+		(void)gus_neighbors_add(addr, random_rssi(), i);
+	}
+
+	return (double)(now_ns() - start) / SAMPLES;
+}
+
+static double bench_reports(int neighbors)
+{
+	struct gus_report_data report[NUM_PROXIMITY_REPORTS];
+	uint8_t buf[BT_MESH_GUS_MSG_MAXLEN_REPORT_COMPACT_REPLY];
+
+	fill(neighbors);
+
+	uint64_t start = now_ns();
+
+	for (uint32_t i = 0; i < REPORTS; ++i) {
+		size_t count = gus_neighbors_top(report, NUM_PROXIMITY_REPORTS,
+						 -127);
+
+		sink += gus_core_compact_encode(OWN_ADDR, report, count, buf);
+	}
+
+	return (double)(now_ns() - start) / REPORTS;
+}
+
+static double bench_rounds(int neighbors)
+{
+	uint64_t total = 0;
+
+	for (uint32_t i = 0; i < ROUNDS; ++i) {
+		fill(neighbors);
+
+		uint64_t start = now_ns();
+
+		gus_neighbors_new_round();
+		total += now_ns() - start;
+	}
+
+	return (double)total / ROUNDS;
+}
+
+int main(int argc, char **argv)
+{
+	const int neighbors[] = { 1, 8, TABLE_SIZE / 4, TABLE_SIZE / 2,
+				 TABLE_SIZE };
+	double max_sample = argc > 1 ? atof(argv[1]) : 0;
+	double max_report = argc > 2 ? atof(argv[2]) : 0;
+	int ret = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(neighbors); ++i) {
+		double sample = bench_samples(neighbors[i]);
+		double report = bench_reports(neighbors[i]);
+		double round = bench_rounds(neighbors[i]);
+
+		printf("table %3d neighbors %3d: %6.1f ns/sample %7.1f "
+		       "ns/report %8.1f ns/round\n",
+		       TABLE_SIZE, neighbors[i], sample, report, round);
+
+		if ((max_sample > 0 && sample > max_sample) ||
+		    (max_report > 0 && report > max_report)) {
+			ret = 1;
+		}
+	}
+
+	if (ret) {
+		fprintf(stderr, "gus_bench: over the limit of %.1f ns/sample "
+			"or %.1f ns/report\n", max_sample, max_report);
+	}
+
+	return ret;
+}
@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/////////////////////////////////////////////////////////////////////////
+// Proximity core unit tests.
+// The neighbor table source is included, so the tests can check its
+// internals after every operation:
+//   index    - every entry is found through the hash index, and the index
+//              holds nothing else
+//   top      - the heap is a valid min-heap, holds min(count, TOP_SIZE)
+//              entries, and no entry outside is stronger than its root
+//   exposure - the contact table is sorted by address
+// The compact report codec and the name hash of the core are checked
+// against fixed cases.
+// Exits with 1 if a check fails.
+/////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "gus_neighbors.c"
+
+#define FIRST_ADDR   0x0002
+#define STRONG_RSSI  -40
+#define WEAK_RSSI    -80
+#define RANDOM_OPS   200000
+#define OWN_ADDR     0x0100
+
+static uint32_t rng_state = 0x47555321;
+static int failures;
+
+#define CHECK(cond)                                                      \
+	do {                                                             \
+		if (!(cond)) {                                           \
+			printf("%s:%d: %s: check failed: %s\n", __FILE__, \
+			       __LINE__, __func__, #cond);               \
+			failures++;                                      \
+		}                                                        \
+	} while (0)
+
+static uint32_t rng(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+static bool check_index(void)
+{
+	int used = 0;
+
+	for (uint8_t i = 0; i < tbl.count; ++i) {
+		if (tbl.index[find_slot(tbl.addr[i])] != i) {
+			return false;
+		}
+	}
+
+	for (int slot = 0; slot < HASH_SIZE; ++slot) {
+		used += tbl.index[slot] != NO_ENTRY;
+	}
+
+	return used == tbl.count;
+}
+
+static bool check_top(void)
+{
+	if (tbl.top_len != MIN(tbl.count, TOP_SIZE)) {
+		return false;
+	}
+
+	for (uint8_t pos = 0; pos < tbl.top_len; ++pos) {
+		uint8_t entry = tbl.top[pos];
+
+		if (tbl.heap_pos[entry] != pos ||
+		    (pos > 0 && tbl.rssi[tbl.top[(pos - 1) / 2]] >
+				tbl.rssi[entry])) {
+			return false;
+		}
+	}
+
+	for (uint8_t i = 0; i < tbl.count; ++i) {
+		if (tbl.heap_pos[i] == NO_ENTRY && tbl.top_len > 0 &&
+		    tbl.rssi[i] > tbl.rssi[tbl.top[0]]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool check_exposure(void)
+{
+	for (uint8_t i = 1; i < exp.count; ++i) {
+		if (exp.addr[i - 1] >= exp.addr[i]) {
+			return false;
+		}
+	}
+
+	return exp.count <= EXPOSURE_SIZE;
+}
+
+static bool in_report(const struct gus_report_data *report, size_t len,
+		      uint16_t addr)
+{
+	for (size_t i = 0; i < len; ++i) {
+		if (report[i].addr == addr) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void test_insert(void)
+{
+	gus_neighbors_reset();
+
+	for (int i = 0; i < TABLE_SIZE; ++i) {
+		CHECK(gus_neighbors_add(FIRST_ADDR + i, WEAK_RSSI, 0) == 0);
+	}
+	CHECK(gus_neighbors_count() == TABLE_SIZE);
+	CHECK(gus_neighbors_add(FIRST_ADDR + TABLE_SIZE, WEAK_RSSI, 0) ==
+	      -ENOMEM);
+
+	// a known neighbor still gets its samples in a full table
+	CHECK(gus_neighbors_add(FIRST_ADDR, STRONG_RSSI, 1000) == 0);
+	CHECK(gus_neighbors_count() == TABLE_SIZE);
+	CHECK(gus_neighbors_touch(FIRST_ADDR + 1, 2000) == 0);
+	CHECK(gus_neighbors_touch(FIRST_ADDR + TABLE_SIZE, 2000) == -ENOENT);
+
+	CHECK(check_index());
+	CHECK(check_top());
+}
+
+// the strong neighbors are heard once and age out while the weak ones are
+// still heard every round: the weak ones must take over the report
+static void test_age(void)
+{
+	struct gus_report_data report[TOP_SIZE];
+	size_t len;
+
+	gus_neighbors_reset();
+
+	for (int i = 0; i < TOP_SIZE; ++i) {
+		(void)gus_neighbors_add(FIRST_ADDR + i, STRONG_RSSI, 0);
+	}
+
+	for (int round = 0; round <= CONFIG_GUS_NEIGHBOR_MAX_AGE; ++round) {
+		for (int i = 0; i < TOP_SIZE; ++i) {
+			(void)gus_neighbors_add(FIRST_ADDR + TOP_SIZE + i,
+						WEAK_RSSI, round * 1000);
+		}
+
+		len = gus_neighbors_top(report, TOP_SIZE, INT8_MIN);
+		CHECK(len == TOP_SIZE);
+		CHECK(in_report(report, len, FIRST_ADDR));
+		CHECK(check_top());
+
+		gus_neighbors_new_round();
+	}
+
+	CHECK(gus_neighbors_count() == TOP_SIZE);
+	CHECK(check_index());
+	CHECK(check_top());
+
+	len = gus_neighbors_top(report, TOP_SIZE, INT8_MIN);
+	CHECK(len == TOP_SIZE);
+	for (int i = 0; i < TOP_SIZE; ++i) {
+		CHECK(in_report(report, len, FIRST_ADDR + TOP_SIZE + i));
+	}
+
+	// all gone after MAX_AGE more rounds without samples
+	for (int round = 0; round <= CONFIG_GUS_NEIGHBOR_MAX_AGE; ++round) {
+		gus_neighbors_new_round();
+	}
+	CHECK(gus_neighbors_count() == 0);
+	CHECK(gus_neighbors_top(report, TOP_SIZE, INT8_MIN) == 0);
+	CHECK(check_index());
+}
+
+// addresses one hash apart collide in the index, removing any of them
+// must leave the others reachable
+static void test_delete(void)
+{
+	gus_neighbors_reset();
+
+	for (int i = 0; i < TABLE_SIZE; ++i) {
+		(void)gus_neighbors_add(FIRST_ADDR + i * HASH_SIZE,
+					WEAK_RSSI, 0);
+	}
+	CHECK(check_index());
+
+	// keep every other neighbor
+	for (int round = 0; round < CONFIG_GUS_NEIGHBOR_MAX_AGE; ++round) {
+		gus_neighbors_new_round();
+		for (int i = 0; i < TABLE_SIZE; i += 2) {
+			(void)gus_neighbors_add(FIRST_ADDR + i * HASH_SIZE,
+						WEAK_RSSI, 0);
+		}
+	}
+	gus_neighbors_new_round();
+
+	CHECK(gus_neighbors_count() == TABLE_SIZE / 2);
+	CHECK(check_index());
+	CHECK(check_top());
+	for (int i = 0; i < TABLE_SIZE; ++i) {
+		int err = gus_neighbors_touch(FIRST_ADDR + i * HASH_SIZE, 0);
+
+		CHECK(err == ((i % 2) ? -ENOENT : 0));
+	}
+}
+
+// random samples and rounds, with the invariants checked after each one
+static void test_random(void)
+{
+	int bad_index = 0;
+	int bad_top = 0;
+	int bad_exposure = 0;
+
+	gus_neighbors_reset();
+
+	for (uint32_t op = 0; op < RANDOM_OPS; ++op) {
+		if (rng() % 20 == 0) {
+			gus_neighbors_new_round();
+		} else {
+			(void)gus_neighbors_add(FIRST_ADDR +
+						rng() % (TABLE_SIZE + 32),
+						-30 - (int8_t)(rng() % 70),
+						op * 100);
+		}
+
+		bad_index += !check_index();
+		bad_top += !check_top();
+		bad_exposure += !check_exposure();
+	}
+
+	CHECK(bad_index == 0);
+	CHECK(bad_top == 0);
+	CHECK(bad_exposure == 0);
+}
+
+// contact time outlives the neighbor, and pages through every address
+// exactly once
+static void test_exposure(void)
+{
+	struct gus_exposure_data exposure[8];
+	uint16_t after = 0;
+	size_t total = 0;
+	size_t len;
+
+	gus_neighbors_reset();
+
+	for (uint32_t now = 0; now <= 10000; now += 1000) {
+		(void)gus_neighbors_add(FIRST_ADDR, STRONG_RSSI, now);
+	}
+	for (int round = 0; round <= CONFIG_GUS_NEIGHBOR_MAX_AGE; ++round) {
+		gus_neighbors_new_round();
+	}
+
+	CHECK(gus_neighbors_count() == 0);
+	CHECK(gus_neighbors_find(FIRST_ADDR, &exposure[0]) == 0);
+	for (int band = 0; band < BT_MESH_GUS_EXPOSURE_BANDS; ++band) {
+		CHECK(exposure[0].seconds[band] == 10);
+	}
+
+	// added in falling address order, read back rising
+	for (int i = 40; i > 0; --i) {
+		(void)gus_neighbors_add(FIRST_ADDR + i, WEAK_RSSI + 10, 0);
+		(void)gus_neighbors_add(FIRST_ADDR + i, WEAK_RSSI + 10, 2000);
+	}
+	CHECK(check_exposure());
+	CHECK(gus_neighbors_exposure_count() == MIN(41, EXPOSURE_SIZE));
+
+	do {
+		len = gus_neighbors_exposure(after, exposure,
+					     ARRAY_SIZE(exposure));
+		for (size_t i = 0; i < len; ++i) {
+			CHECK(exposure[i].addr > after);
+			after = exposure[i].addr;
+		}
+		total += len;
+	} while (len == ARRAY_SIZE(exposure));
+
+	CHECK(total == gus_neighbors_exposure_count());
+	CHECK(gus_neighbors_find(FIRST_ADDR + 41, &exposure[0]) == -ENOENT);
+}
+
+// entries round trip with the rssi rounded down to its level, and an
+// address too far from the reporter is sent in full
+static void test_compact(void)
+{
+	const struct gus_report_data report[] = {
+		{ OWN_ADDR + 5, -40, BT_MESH_GUS_CONFIDENCE_HIGH },
+		{ 0, -50, BT_MESH_GUS_CONFIDENCE_HIGH },
+		{ OWN_ADDR + INT8_MIN, -71, BT_MESH_GUS_CONFIDENCE_LOW },
+		{ OWN_ADDR + INT8_MAX + 1, -120, BT_MESH_GUS_CONFIDENCE_MEDIUM },
+	};
+	uint8_t out[BT_MESH_GUS_MSG_MAXLEN_REPORT_COMPACT_REPLY];
+	struct gus_report_data decoded[NUM_PROXIMITY_REPORTS];
+	size_t len;
+
+	// the unassigned entry is dropped
+	len = gus_core_compact_encode(OWN_ADDR, report, ARRAY_SIZE(report),
+				      out);
+	CHECK(len == 1 + 2 + 2 + 3);
+	CHECK(out[0] == 3);
+	CHECK(!(out[1] & BT_MESH_GUS_COMPACT_LONG_ADDR));
+	CHECK(!(out[3] & BT_MESH_GUS_COMPACT_LONG_ADDR));
+	CHECK(out[5] & BT_MESH_GUS_COMPACT_LONG_ADDR);
+
+	CHECK(gus_core_compact_decode(OWN_ADDR, out, len, decoded,
+				      ARRAY_SIZE(decoded)) == 3);
+	CHECK(decoded[0].addr == OWN_ADDR + 5);
+	CHECK(decoded[0].rssi == -40);
+	CHECK(decoded[0].confidence == BT_MESH_GUS_CONFIDENCE_HIGH);
+	CHECK(decoded[1].addr == OWN_ADDR + INT8_MIN);
+	CHECK(decoded[1].rssi == -72);
+	CHECK(decoded[1].confidence == BT_MESH_GUS_CONFIDENCE_LOW);
+	CHECK(decoded[2].addr == OWN_ADDR + INT8_MAX + 1);
+	CHECK(decoded[2].rssi == BT_MESH_GUS_COMPACT_RSSI_MIN);
+	CHECK(decoded[2].confidence == BT_MESH_GUS_CONFIDENCE_MEDIUM);
+
+	// every cut of the message, and a count beyond its entries
+	for (size_t cut = 0; cut < len; ++cut) {
+		CHECK(gus_core_compact_decode(OWN_ADDR, out, cut, decoded,
+					      ARRAY_SIZE(decoded)) == -1);
+	}
+	out[0]++;
+	CHECK(gus_core_compact_decode(OWN_ADDR, out, len, decoded,
+				      ARRAY_SIZE(decoded)) == -1);
+
+	// an empty report is just the count
+	len = gus_core_compact_encode(OWN_ADDR, report, 0, out);
+	CHECK(len == 1 && out[0] == 0);
+	CHECK(gus_core_compact_decode(OWN_ADDR, out, len, decoded,
+				      ARRAY_SIZE(decoded)) == 0);
+}
+
+// the encoder sends at most NUM_PROXIMITY_REPORTS entries, and the decoder
+// fills no more than it has room for
+static void test_compact_limits(void)
+{
+	struct gus_report_data report[NUM_PROXIMITY_REPORTS + 2];
+	uint8_t out[BT_MESH_GUS_MSG_MAXLEN_REPORT_COMPACT_REPLY];
+	struct gus_report_data decoded[2];
+	size_t len;
+
+	for (size_t i = 0; i < ARRAY_SIZE(report); ++i) {
+		report[i].addr = OWN_ADDR + 0x1000 + i;
+		report[i].rssi = STRONG_RSSI;
+		report[i].confidence = BT_MESH_GUS_CONFIDENCE_HIGH;
+	}
+
+	len = gus_core_compact_encode(OWN_ADDR, report, ARRAY_SIZE(report),
+				      out);
+	CHECK(out[0] == NUM_PROXIMITY_REPORTS);
+	CHECK(len == BT_MESH_GUS_MSG_MAXLEN_REPORT_COMPACT_REPLY);
+
+	CHECK(gus_core_compact_decode(OWN_ADDR, out, len, decoded,
+				      ARRAY_SIZE(decoded)) ==
+	      ARRAY_SIZE(decoded));
+	for (size_t i = 0; i < ARRAY_SIZE(decoded); ++i) {
+		CHECK(decoded[i].addr == report[i].addr);
+	}
+}
+
+// published FNV-1a 32 bit vectors, xor folded to 16 bits
+static void test_name_hash(void)
+{
+	CHECK(gus_core_name_hash("") == (0x811c ^ 0x9dc5));
+	CHECK(gus_core_name_hash("a") == (0xe40c ^ 0x292c));
+	CHECK(gus_core_name_hash("foobar") == (0xbf9c ^ 0xf968));
+}
+
+int main(void)
+{
+	test_insert();
+	test_age();
+	test_delete();
+	test_random();
+	test_exposure();
+	test_compact();
+	test_compact_limits();
+	test_name_hash();
+
+	printf("table %d, max age %d: %s\n", TABLE_SIZE,
+	       CONFIG_GUS_NEIGHBOR_MAX_AGE, failures ? "FAILED" : "passed");
+
+	return failures ? 1 : 0;
+}
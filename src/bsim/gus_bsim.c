@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/////////////////////////////////////////////////////////////////////////
+// BabbleSim support.
+// All badges share a fixed network and application key and provision
+// themselves at boot, device N getting address N + 1.  The badges publish
+// their proximity beacons to, and subscribe to, the same group.
+//
+// Device 0 is the collector.  Once every badge had time to configure
+// itself, it collects a compact report from every badge with the Gus
+// client and prints one line per round with the round time, the replies,
+// the badges that never replied and the client request counters.
+// The lines start with "gus_bsim:" so bsim/run_sweep.sh can pick them
+// out of the console output.
+/////////////////////////////////////////////////////////////////////////
+
+#include <zephyr.h>
+#include <bluetooth/mesh.h>
+#include <sys/byteorder.h>
+#include <string.h>
+#include "argparse.h"
+#include "gus_bsim.h"
+
+#define NET_IDX         0
+#define APP_IDX         0
+#define GROUP_ADDR      0xc000
+#define COLLECTOR_ADDR  0x0001
+#define FIRST_BADGE     (COLLECTOR_ADDR + 1)
+#define SETTLE_MS       3000   // time for all badges to configure themselves
+
+static const uint8_t net_key[16] = {
+	0x47, 0x55, 0x53, 0x20, 0x6e, 0x65, 0x74, 0x20,
+	0x6b, 0x65, 0x79, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+static const uint8_t app_key[16] = {
+	0x47, 0x55, 0x53, 0x20, 0x61, 0x70, 0x70, 0x20,
+	0x6b, 0x65, 0x79, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static uint16_t own_addr;
+static uint8_t dev_uuid[16];
+
+struct bt_mesh_cfg_cli gus_bsim_cfg_cli;
+
+static const struct bt_mesh_prov prov = {
+	.uuid = dev_uuid,
+};
+
+static K_SEM_DEFINE(start_sem, 0, 1);
+static K_SEM_DEFINE(done_sem, 0, 1);
+
+static uint16_t badges[CONFIG_GUS_BSIM_BADGES];
+
+static struct {
+	uint32_t replies;
+	uint32_t missing;
+	uint32_t contacts;
+} round_stats;
+
+/////////////////////////////
+// collector
+/////////////////////////////
+
+static void cli_report(struct bt_mesh_gus_cli *cli,
+		       struct bt_mesh_msg_ctx *ctx,
+		       const struct gus_report_data *report, size_t count)
+{
+	round_stats.replies++;
+	round_stats.contacts += count;
+}
+
+static void cli_timeout(struct bt_mesh_gus_cli *cli, uint16_t addr)
+{
+	round_stats.missing++;
+}
+
+static void cli_done(struct bt_mesh_gus_cli *cli)
+{
+	k_sem_give(&done_sem);
+}
+
+static const struct bt_mesh_gus_cli_handlers cli_handlers = {
+	.report = cli_report,
+	.timeout = cli_timeout,
+	.done = cli_done,
+};
+
+struct bt_mesh_gus_cli gus_bsim_cli = {
+	.handlers = &cli_handlers,
+};
+
+static void collector_run(void)
+{
+	struct bt_mesh_msg_ctx ctx = {
+		.net_idx = NET_IDX,
+		.app_idx = APP_IDX,
+		.send_ttl = BT_MESH_TTL_DEFAULT,
+	};
+
+	for (int i = 0; i < ARRAY_SIZE(badges); ++i) {
+		badges[i] = FIRST_BADGE + i;
+	}
+
+	k_sleep(K_MSEC(SETTLE_MS));
+
+	for (int round = 0; round < CONFIG_GUS_BSIM_ROUNDS; ++round) {
+		int64_t start = k_uptime_get();
+		uint32_t sent = gus_bsim_cli.stats.sent;
+		uint32_t retries = gus_bsim_cli.stats.retries;
+		uint32_t send_err = gus_bsim_cli.stats.send_err;
+		int err;
+
+		memset(&round_stats, 0, sizeof(round_stats));
+
+		err = bt_mesh_gus_cli_collect(&gus_bsim_cli, &ctx,
+					      BT_MESH_GUS_OP_REPORT_COMPACT,
+					      badges, ARRAY_SIZE(badges));
+		if (err) {
+			printk("gus_bsim: collect failed (err %d)\n", err);
+			return;
+		}
+
+		k_sem_take(&done_sem, K_FOREVER);
+
+		printk("gus_bsim: round %d badges %d time_ms %lld replies %u "
+		       "missing %u contacts %u sent %u retries %u "
+		       "send_err %u\n",
+		       round, CONFIG_GUS_BSIM_BADGES, k_uptime_get() - start,
+		       round_stats.replies, round_stats.missing,
+		       round_stats.contacts, gus_bsim_cli.stats.sent - sent,
+		       gus_bsim_cli.stats.retries - retries,
+		       gus_bsim_cli.stats.send_err - send_err);
+	}
+
+	printk("gus_bsim: done\n");
+}
+
+/////////////////////////////
+// self provisioning
+/////////////////////////////
+
+static int configure(void)
+{
+	struct bt_mesh_cfg_mod_pub pub = {
+		.addr = GROUP_ADDR,
+		.app_idx = APP_IDX,
+		.ttl = BT_MESH_TTL_DEFAULT,
+		.transmit = BT_MESH_TRANSMIT(2, 20),
+	};
+	uint8_t status;
+	int err;
+
+	err = bt_mesh_cfg_app_key_add(NET_IDX, own_addr, NET_IDX, APP_IDX,
+				      app_key, &status);
+	if (err || status) {
+		return err ? err : -EIO;
+	}
+
+	uint16_t models[] = { BT_MESH_GUS_VENDOR_MODEL_ID,
+			      BT_MESH_GUS_CLI_VENDOR_MODEL_ID };
+
+	for (int i = 0; i < ARRAY_SIZE(models); ++i) {
+		err = bt_mesh_cfg_mod_app_bind_vnd(
+			NET_IDX, own_addr, own_addr, APP_IDX, models[i],
+			BT_MESH_GUS_VENDOR_COMPANY_ID, &status);
+		if (err || status) {
+			return err ? err : -EIO;
+		}
+	}
+
+	err = bt_mesh_cfg_mod_pub_set_vnd(NET_IDX, own_addr, own_addr,
+					  BT_MESH_GUS_VENDOR_MODEL_ID,
+					  BT_MESH_GUS_VENDOR_COMPANY_ID, &pub,
+					  &status);
+	if (err || status) {
+		return err ? err : -EIO;
+	}
+
+	err = bt_mesh_cfg_mod_sub_add_vnd(NET_IDX, own_addr, own_addr,
+					  GROUP_ADDR,
+					  BT_MESH_GUS_VENDOR_MODEL_ID,
+					  BT_MESH_GUS_VENDOR_COMPANY_ID,
+					  &status);
+	return err ? err : (status ? -EIO : 0);
+}
+
+// Runs in its own thread: the configuration client waits for the replies,
+// which are looped back through the system work queue, so it must not be
+// called from bt_ready().
+static void bsim_thread(void)
+{
+	uint8_t dev_key[16] = { 0 };
+	int err;
+
+	k_sem_take(&start_sem, K_FOREVER);
+
+	sys_put_be16(own_addr, dev_key);
+
+	err = bt_mesh_provision(net_key, NET_IDX, 0, 0, own_addr, dev_key);
+	if (err) {
+		printk("gus_bsim: provisioning failed (err %d)\n", err);
+		return;
+	}
+
+	err = configure();
+	if (err) {
+		printk("gus_bsim: configuration failed (err %d)\n", err);
+		return;
+	}
+
+	printk("gus_bsim: badge 0x%04x ready\n", own_addr);
+
+	if (own_addr == COLLECTOR_ADDR) {
+		collector_run();
+	}
+}
+
+K_THREAD_DEFINE(gus_bsim, 2048, bsim_thread, NULL, NULL, NULL,
+		K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+const struct bt_mesh_prov *gus_bsim_prov_init(void)
+{
+	own_addr = COLLECTOR_ADDR + get_device_nbr();
+	sys_put_be16(own_addr, dev_uuid);
+
+	return &prov;
+}
+
+void gus_bsim_start(void)
+{
+	k_sem_give(&start_sem);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief BabbleSim support for the GUS badge.
+ *
+ * Only built for the nrf52_bsim board. Every simulated device provisions
+ * and configures itself at boot, with unicast address device number + 1.
+ * Device 0 is the collector: it collects a compact report from every
+ * badge with the Gus client and prints how long a full round took.
+ */
+
+#ifndef GUS_BSIM_H__
+#define GUS_BSIM_H__
+
+#include <bluetooth/mesh.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef CONFIG_BOARD_NRF52_BSIM
+
+#include "../gus_cli.h"
+
+extern struct bt_mesh_cfg_cli gus_bsim_cfg_cli;
+extern struct bt_mesh_gus_cli gus_bsim_cli;
+
+/** SIG models added to the badge element in the simulation. */
+#define GUS_BSIM_SIG_MODELS BT_MESH_MODEL_CFG_CLI(&gus_bsim_cfg_cli),
+
+/** Vendor models added to the badge element in the simulation. */
+#define GUS_BSIM_VND_MODELS , BT_MESH_MODEL_GUS_CLI(&gus_bsim_cli)
+
+/** @brief Get the provisioning properties of a simulated badge.
+ *
+ * @return Provisioning properties to pass to bt_mesh_init().
+ */
+const struct bt_mesh_prov *gus_bsim_prov_init(void);
+
+/** @brief Provision and configure the simulated badge.
+ *
+ * Called instead of bt_mesh_prov_enable() once the mesh is initialized.
+ * On device 0, this also starts the collector.
+ */
+void gus_bsim_start(void);
+
+#else
+
+#define GUS_BSIM_SIG_MODELS
+#define GUS_BSIM_VND_MODELS
+
+#endif /* CONFIG_BOARD_NRF52_BSIM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_BSIM_H__ */
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include "gus_boot.h"
+
+// microseconds, 64 bit: a badge may be provisioned, and get ready, hours
+// after it booted
+static uint64_t stamps[GUS_BOOT_PHASES];
+
+static const char *const names[GUS_BOOT_PHASES] = {
+	[GUS_BOOT_LEDS] = "leds",
+	[GUS_BOOT_STATE] = "state",
+	[GUS_BOOT_BT] = "bt",
+	[GUS_BOOT_MESH] = "mesh",
+	[GUS_BOOT_READY] = "ready",
+};
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+void gus_boot_mark(enum gus_boot_phase phase)
+{
+	if (phase >= GUS_BOOT_PHASES || stamps[phase]) {
+		return;
+	}
+
+	// never 0, which means "not reached"
+	stamps[phase] = MAX(k_ticks_to_us_floor64(k_uptime_ticks()), 1);
+
+	if (phase == GUS_BOOT_READY) {
+		printk("boot:");
+		for (int i = 0; i < GUS_BOOT_PHASES; ++i) {
+			printk(" %s %u ms", names[i],
+			       (uint32_t)(stamps[i] / 1000));
+		}
+		printk("\n");
+	}
+}
+
+uint64_t gus_boot_time_us(enum gus_boot_phase phase)
+{
+	return phase < GUS_BOOT_PHASES ? stamps[phase] : 0;
+}
+
+const char *gus_boot_name(enum gus_boot_phase phase)
+{
+	return phase < GUS_BOOT_PHASES ? names[phase] : "?";
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus boot phase timestamps
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// Boot phases - the badge starts in stages so it shows signs of life early:
+//   leds   - the LED driver and engine are up, all LEDs flash
+//   state  - the health state stored in flash is shown on the LEDs
+//   bt     - the Bluetooth stack is enabled (bt_ready)
+//   mesh   - the mesh is initialized and its settings are loaded
+//   ready  - the Gus server is started, i.e. the badge is provisioned
+// Each phase is stamped with the uptime in microseconds the first time it
+// is reached.  The stamps are printed once the badge is ready and can be
+// read again with the "gus boot" shell command.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GUS_BOOT_H__
+#define GUS_BOOT_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum gus_boot_phase {
+	GUS_BOOT_LEDS,
+	GUS_BOOT_STATE,
+	GUS_BOOT_BT,
+	GUS_BOOT_MESH,
+	GUS_BOOT_READY,
+
+	GUS_BOOT_PHASES,
+};
+
+/** @brief Stamp a boot phase with the current uptime.
+ *
+ * Only the first call for each phase counts.  Reaching GUS_BOOT_READY
+ * prints all phases.
+ *
+ * @param[in] phase Boot phase reached.
+ */
+void gus_boot_mark(enum gus_boot_phase phase);
+
+/** @brief Get the time a boot phase was reached.
+ *
+ * @param[in] phase Boot phase.
+ *
+ * @return Uptime in microseconds, 0 if the phase was not reached yet.
+ */
+uint64_t gus_boot_time_us(enum gus_boot_phase phase);
+
+/** @brief Get the name of a boot phase.
+ *
+ * @param[in] phase Boot phase.
+ *
+ * @return Short name of the phase.
+ */
+const char *gus_boot_name(enum gus_boot_phase phase);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_BOOT_H__ */
@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifdef CONFIG_GUS_CLI
+
+#include <zephyr.h>
+#include <random/rand32.h>
+#include <sys/byteorder.h>
+#include "gus_cli.h"
+#include "gus_energy.h"
+
+#define LEGACY_ENTRY_LEN 4   // struct gus_report_data as sent by the server
+
+enum req_state {
+	REQ_IDLE,
+	REQ_SEND,      // send when due, after the backoff or a send error
+	REQ_WAIT,      // sent, waiting for the reply until due
+};
+
+static uint32_t reply_op(uint32_t op)
+{
+	switch (op) {
+	case BT_MESH_GUS_OP_SIGN_IN:
+		return BT_MESH_GUS_OP_SIGN_IN_REPLY;
+	case BT_MESH_GUS_OP_REPORT:
+		return BT_MESH_GUS_OP_REPORT_REPLY;
+	case BT_MESH_GUS_OP_REPORT_COMPACT:
+		return BT_MESH_GUS_OP_REPORT_COMPACT_REPLY;
+	default:
+		return 0;
+	}
+}
+
+static int64_t backoff(uint8_t attempts)
+{
+	uint32_t delay = CONFIG_GUS_CLI_BACKOFF_MS << MIN(attempts - 1, 4);
+
+	return delay + sys_rand32_get() % CONFIG_GUS_CLI_BACKOFF_MS;
+}
+
+static int send_request(struct bt_mesh_gus_cli *cli, uint16_t addr)
+{
+	struct bt_mesh_msg_ctx ctx = cli->ctx;
+
+	ctx.addr = addr;
+
+	BT_MESH_MODEL_BUF_DEFINE(msg, BT_MESH_GUS_OP_REPORT_COMPACT,
+				 BT_MESH_GUS_MSG_LEN_REQUEST);
+	bt_mesh_model_msg_init(&msg, cli->op);
+
+	int err = bt_mesh_model_send(cli->model, &ctx, &msg, NULL, NULL);
+
+	if (!err) {
+		gus_energy_tx(msg.len);
+	}
+
+	return err;
+}
+
+static void finish(struct bt_mesh_gus_cli *cli)
+{
+	cli->addrs = NULL;
+	cli->count = 0;
+	cli->next = 0;
+}
+
+static void give_up(struct bt_mesh_gus_cli *cli,
+		    struct bt_mesh_gus_cli_req *req)
+{
+	cli->stats.timeouts++;
+	req->state = REQ_IDLE;
+	if (cli->handlers && cli->handlers->timeout) {
+		cli->handlers->timeout(cli, req->addr);
+	}
+}
+
+// Moves every window slot along: expired requests are retried or given up,
+// free slots take the next badge, and due requests are sent.
+static void process(struct bt_mesh_gus_cli *cli)
+{
+	int64_t now = k_uptime_get();
+	int64_t next_due = INT64_MAX;
+
+	for (int i = 0; i < ARRAY_SIZE(cli->window); ++i) {
+		struct bt_mesh_gus_cli_req *req = &cli->window[i];
+
+		if (req->state == REQ_WAIT && now >= req->due) {
+			if (req->attempts > CONFIG_GUS_CLI_RETRIES) {
+				give_up(cli, req);
+			} else {
+				cli->stats.retries++;
+				req->state = REQ_SEND;
+				req->due = now + backoff(req->attempts);
+			}
+		}
+
+		if (req->state == REQ_IDLE && cli->next < cli->count) {
+			req->addr = cli->addrs[cli->next++];
+			req->attempts = 0;
+			req->state = REQ_SEND;
+			req->due = now;
+		}
+
+		if (req->state == REQ_SEND && now >= req->due) {
+			req->attempts++;
+			if (send_request(cli, req->addr)) {
+				// out of buffers, not a retry: nothing was sent,
+				// so there is no reply to wait for
+				cli->stats.send_err++;
+				if (req->attempts > CONFIG_GUS_CLI_RETRIES) {
+					give_up(cli, req);
+					// refill the slot on the next pass
+					next_due = now;
+				} else {
+					req->due = now + backoff(req->attempts);
+				}
+			} else {
+				cli->stats.sent++;
+				req->state = REQ_WAIT;
+				req->due = now + CONFIG_GUS_CLI_TIMEOUT_MS;
+			}
+		}
+
+		if (req->state != REQ_IDLE) {
+			next_due = MIN(next_due, req->due);
+		}
+	}
+
+	if (next_due != INT64_MAX) {
+		k_work_reschedule(&cli->work, K_MSEC(MAX(next_due - now, 0)));
+	} else if (cli->addrs) {
+		finish(cli);
+		if (cli->handlers && cli->handlers->done) {
+			cli->handlers->done(cli);
+		}
+	}
+}
+
+static void work_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct bt_mesh_gus_cli *cli =
+		CONTAINER_OF(dwork, struct bt_mesh_gus_cli, work);
+
+	k_mutex_lock(&cli->lock, K_FOREVER);
+	process(cli);
+	k_mutex_unlock(&cli->lock);
+}
+
+// Frees the window slot waiting for a reply from addr. A reply that
+// arrives during the backoff of a retry still counts.
+static bool claim(struct bt_mesh_gus_cli *cli, uint32_t op, uint16_t addr)
+{
+	bool found = false;
+
+	k_mutex_lock(&cli->lock, K_FOREVER);
+	if (cli->addrs && reply_op(cli->op) == op) {
+		for (int i = 0; i < ARRAY_SIZE(cli->window); ++i) {
+			struct bt_mesh_gus_cli_req *req = &cli->window[i];
+
+			if (req->state != REQ_IDLE && req->attempts > 0 &&
+			    req->addr == addr) {
+				req->state = REQ_IDLE;
+				found = true;
+				break;
+			}
+		}
+	}
+	k_mutex_unlock(&cli->lock);
+
+	if (found) {
+		k_work_reschedule(&cli->work, K_NO_WAIT);
+	}
+
+	return found;
+}
+
+/////////////////////////////
+// message handlers
+/////////////////////////////
+
+static void handle_sign_in_reply(struct bt_mesh_model *model,
+				 struct bt_mesh_msg_ctx *ctx,
+				 struct net_buf_simple *buf)
+{
+	struct bt_mesh_gus_cli *cli = model->user_data;
+	char name[CONFIG_BT_MESH_GUS_NAME_LENGTH + 1];
+	size_t len = MIN(buf->len, CONFIG_BT_MESH_GUS_NAME_LENGTH);
+
+	if (!claim(cli, BT_MESH_GUS_OP_SIGN_IN_REPLY, ctx->addr)) {
+		return;
+	}
+
+	memcpy(name, net_buf_simple_pull_mem(buf, len), len);
+	name[len] = '\0';
+
+	if (cli->handlers && cli->handlers->sign_in) {
+		cli->handlers->sign_in(cli, ctx, name);
+	}
+}
+
+static void handle_report_reply(struct bt_mesh_model *model,
+				struct bt_mesh_msg_ctx *ctx,
+				struct net_buf_simple *buf)
+{
+	struct bt_mesh_gus_cli *cli = model->user_data;
+	struct gus_report_data report[NUM_PROXIMITY_REPORTS];
+	size_t count = 0;
+
+	if (!claim(cli, BT_MESH_GUS_OP_REPORT_REPLY, ctx->addr)) {
+		return;
+	}
+
+	for (int i = 0; i < NUM_PROXIMITY_REPORTS &&
+			buf->len >= LEGACY_ENTRY_LEN; ++i) {
+		uint16_t addr = net_buf_simple_pull_le16(buf);
+		int8_t rssi = net_buf_simple_pull_u8(buf);
+		uint8_t confidence = net_buf_simple_pull_u8(buf);
+
+		if (addr != BT_MESH_ADDR_UNASSIGNED) {
+			report[count].addr = addr;
+			report[count].rssi = rssi;
+			report[count].confidence = confidence;
+			count++;
+		}
+	}
+
+	if (cli->handlers && cli->handlers->report) {
+		cli->handlers->report(cli, ctx, report, count);
+	}
+}
+
+static void handle_report_compact_reply(struct bt_mesh_model *model,
+					struct bt_mesh_msg_ctx *ctx,
+					struct net_buf_simple *buf)
+{
+	struct bt_mesh_gus_cli *cli = model->user_data;
+	struct gus_report_data report[NUM_PROXIMITY_REPORTS];
+	int count = gus_core_compact_decode(ctx->addr, buf->data, buf->len,
+					    report, ARRAY_SIZE(report));
+
+	if (count < 0 ||
+	    !claim(cli, BT_MESH_GUS_OP_REPORT_COMPACT_REPLY, ctx->addr)) {
+		return;
+	}
+
+	if (cli->handlers && cli->handlers->report) {
+		cli->handlers->report(cli, ctx, report, count);
+	}
+}
+
+static void handle_status(struct bt_mesh_model *model,
+			  struct bt_mesh_msg_ctx *ctx,
+			  struct net_buf_simple *buf)
+{
+	struct bt_mesh_gus_cli *cli = model->user_data;
+	struct bt_mesh_gus_status status;
+
+	status.state = net_buf_simple_pull_u8(buf);
+	status.name_hash = net_buf_simple_pull_le16(buf);
+	status.neighbors = net_buf_simple_pull_u8(buf);
+	status.contacts = net_buf_simple_pull_u8(buf);
+	status.ttl = net_buf_simple_pull_u8(buf);
+
+	if (cli->handlers && cli->handlers->status) {
+		cli->handlers->status(cli, ctx, &status);
+	}
+}
+
+const struct bt_mesh_model_op _bt_mesh_gus_cli_op[] = {
+	{ BT_MESH_GUS_OP_SIGN_IN_REPLY, 0, handle_sign_in_reply },
+	{ BT_MESH_GUS_OP_REPORT_REPLY, 0, handle_report_reply },
+	{ BT_MESH_GUS_OP_REPORT_COMPACT_REPLY, 1,
+	  handle_report_compact_reply },
+	{ BT_MESH_GUS_OP_STATUS, BT_MESH_GUS_MSG_LEN_STATUS, handle_status },
+	BT_MESH_MODEL_OP_END,
+};
+
+static int bt_mesh_gus_cli_init(struct bt_mesh_model *model)
+{
+	struct bt_mesh_gus_cli *cli = model->user_data;
+
+	cli->model = model;
+	k_mutex_init(&cli->lock);
+	k_work_init_delayable(&cli->work, work_handler);
+
+	return 0;
+}
+
+static void bt_mesh_gus_cli_reset(struct bt_mesh_model *model)
+{
+	bt_mesh_gus_cli_cancel(model->user_data);
+}
+
+const struct bt_mesh_model_cb _bt_mesh_gus_cli_cb = {
+	.init = bt_mesh_gus_cli_init,
+	.reset = bt_mesh_gus_cli_reset,
+};
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+int bt_mesh_gus_cli_collect(struct bt_mesh_gus_cli *cli,
+			    const struct bt_mesh_msg_ctx *ctx, uint32_t op,
+			    const uint16_t *addrs, size_t count)
+{
+	if (!reply_op(op)) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&cli->lock, K_FOREVER);
+	if (cli->addrs) {
+		k_mutex_unlock(&cli->lock);
+		return -EBUSY;
+	}
+
+	cli->ctx = *ctx;
+	cli->op = op;
+	cli->addrs = addrs;
+	cli->count = count;
+	cli->next = 0;
+	for (int i = 0; i < ARRAY_SIZE(cli->window); ++i) {
+		cli->window[i].state = REQ_IDLE;
+	}
+	k_mutex_unlock(&cli->lock);
+
+	k_work_reschedule(&cli->work, K_NO_WAIT);
+	return 0;
+}
+
+int bt_mesh_gus_cli_set_states(struct bt_mesh_gus_cli *cli,
+			       struct bt_mesh_msg_ctx *ctx, uint16_t base,
+			       const uint8_t *states, size_t count)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, BT_MESH_GUS_OP_SET_STATES,
+				 BT_MESH_GUS_MSG_MAXLEN_SET_STATES);
+	int err;
+
+	if (count == 0 || count > BT_MESH_GUS_SET_STATES_MAX) {
+		return -EINVAL;
+	}
+
+	bt_mesh_model_msg_init(&msg, BT_MESH_GUS_OP_SET_STATES);
+	net_buf_simple_add_le16(&msg, base);
+	for (size_t i = 0; i < count; i += 2) {
+		uint8_t high = (i + 1 < count) ? states[i + 1] :
+						 BT_MESH_GUS_STATE_UNCHANGED;
+
+		net_buf_simple_add_u8(&msg,
+				      (states[i] & 0xf) | ((high & 0xf) << 4));
+	}
+
+	err = bt_mesh_model_send(cli->model, ctx, &msg, NULL, NULL);
+	if (!err) {
+		gus_energy_tx(msg.len);
+	}
+
+	return err;
+}
+
+void bt_mesh_gus_cli_cancel(struct bt_mesh_gus_cli *cli)
+{
+	k_mutex_lock(&cli->lock, K_FOREVER);
+	finish(cli);
+	for (int i = 0; i < ARRAY_SIZE(cli->window); ++i) {
+		cli->window[i].state = REQ_IDLE;
+	}
+	k_mutex_unlock(&cli->lock);
+
+	k_work_cancel_delayable(&cli->work);
+}
+
+bool bt_mesh_gus_cli_busy(struct bt_mesh_gus_cli *cli)
+{
+	return cli->addrs != NULL;
+}
+
+#endif /* CONFIG_GUS_CLI */
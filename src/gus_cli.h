@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus client model
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// GUS Client model - collects sign-ins and reports from a list of badges.
+//
+// Up to CONFIG_GUS_CLI_WINDOW requests are outstanding at a time.  Replies
+// are matched to the request by source address, and a free window slot is
+// refilled with the next badge as soon as its reply arrives.  A request
+// without reply is sent again after CONFIG_GUS_CLI_TIMEOUT_MS, waiting an
+// exponential backoff with random jitter first, up to
+// CONFIG_GUS_CLI_RETRIES times.  So a full room is collected in a few
+// round trips instead of one round trip per badge.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BT_MESH_GUS_CLI_H__
+#define BT_MESH_GUS_CLI_H__
+
+#include <bluetooth/mesh.h>
+#include "gus_svr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Model ID of the Bluetooth Mesh Gus client model. */
+#define BT_MESH_GUS_CLI_VENDOR_MODEL_ID 0x0043
+
+struct bt_mesh_gus_cli;
+
+/** @def BT_MESH_MODEL_GUS_CLI
+ *
+ * @brief Bluetooth Mesh Gus client model composition data entry.
+ *
+ * @param[in] _cli Pointer to a @ref bt_mesh_gus_cli instance.
+ */
+#define BT_MESH_MODEL_GUS_CLI(_cli)                                   \
+		BT_MESH_MODEL_VND_CB(BT_MESH_GUS_VENDOR_COMPANY_ID,   \
+			BT_MESH_GUS_CLI_VENDOR_MODEL_ID,              \
+			_bt_mesh_gus_cli_op, NULL,                    \
+			BT_MESH_MODEL_USER_DATA(struct bt_mesh_gus_cli, \
+						_cli),                \
+			&_bt_mesh_gus_cli_cb)
+
+/** Gus client callbacks. All callbacks are optional. */
+struct bt_mesh_gus_cli_handlers {
+	/** @brief A badge replied to a sign-in request.
+	 *
+	 * @param[in] cli  Gus client that collects.
+	 * @param[in] ctx  Context of the reply.
+	 * @param[in] name Name of the badge.
+	 */
+	void (*const sign_in)(struct bt_mesh_gus_cli *cli,
+			      struct bt_mesh_msg_ctx *ctx, const char *name);
+
+	/** @brief A badge replied to a report or compact report request.
+	 *
+	 * @param[in] cli    Gus client that collects.
+	 * @param[in] ctx    Context of the reply.
+	 * @param[in] report Valid report entries.
+	 * @param[in] count  Number of entries in @p report.
+	 */
+	void (*const report)(struct bt_mesh_gus_cli *cli,
+			     struct bt_mesh_msg_ctx *ctx,
+			     const struct gus_report_data *report,
+			     size_t count);
+
+	/** @brief A badge published its status.
+	 *
+	 * Not tied to a collection.  The client model must subscribe to the
+	 * address the badges publish to.
+	 *
+	 * @param[in] cli    Gus client that received the status.
+	 * @param[in] ctx    Context of the status message.
+	 * @param[in] status Status of the badge.
+	 */
+	void (*const status)(struct bt_mesh_gus_cli *cli,
+			     struct bt_mesh_msg_ctx *ctx,
+			     const struct bt_mesh_gus_status *status);
+
+	/** @brief A badge did not reply to any of the retries.
+	 *
+	 * @param[in] cli  Gus client that collects.
+	 * @param[in] addr Address of the badge.
+	 */
+	void (*const timeout)(struct bt_mesh_gus_cli *cli, uint16_t addr);
+
+	/** @brief Every badge of the collection replied or timed out.
+	 *
+	 * @param[in] cli Gus client that collected.
+	 */
+	void (*const done)(struct bt_mesh_gus_cli *cli);
+};
+
+/** Outstanding request, internal. */
+struct bt_mesh_gus_cli_req {
+	uint16_t addr;
+	uint8_t state;
+	uint8_t attempts;
+	int64_t due;
+};
+
+/** Gus client instance. */
+struct bt_mesh_gus_cli {
+	/** Callbacks, may be NULL. */
+	const struct bt_mesh_gus_cli_handlers *handlers;
+	/** Access model pointer. */
+	struct bt_mesh_model *model;
+	/** Request counters, since boot. */
+	struct {
+		uint32_t sent;
+		uint32_t retries;
+		uint32_t send_err;
+		uint32_t timeouts;
+	} stats;
+
+	/* Internal collection state. */
+	struct bt_mesh_gus_cli_req window[CONFIG_GUS_CLI_WINDOW];
+	struct bt_mesh_msg_ctx ctx;
+	uint32_t op;
+	const uint16_t *addrs;
+	size_t count;
+	size_t next;
+	struct k_mutex lock;
+	struct k_work_delayable work;
+};
+
+/** @cond INTERNAL_HIDDEN */
+extern const struct bt_mesh_model_op _bt_mesh_gus_cli_op[];
+extern const struct bt_mesh_model_cb _bt_mesh_gus_cli_cb;
+/** @endcond */
+
+/** @brief Collect replies from a list of badges.
+ *
+ * @param[in] cli   Gus client instance.
+ * @param[in] ctx   Network and application key and TTL to send with, the
+ *                  address is ignored.
+ * @param[in] op    BT_MESH_GUS_OP_SIGN_IN, BT_MESH_GUS_OP_REPORT or
+ *                  BT_MESH_GUS_OP_REPORT_COMPACT.
+ * @param[in] addrs Unicast addresses of the badges. Must stay valid until
+ *                  the done callback.
+ * @param[in] count Number of addresses in @p addrs.
+ *
+ * @retval 0       The collection was started.
+ * @retval -EINVAL @p op is not a request the client can collect.
+ * @retval -EBUSY  A collection is already running.
+ */
+int bt_mesh_gus_cli_collect(struct bt_mesh_gus_cli *cli,
+			    const struct bt_mesh_msg_ctx *ctx, uint32_t op,
+			    const uint16_t *addrs, size_t count);
+
+/** @brief Set the state of a range of badges with one message.
+ *
+ * Independent of a running collection.
+ *
+ * @param[in] cli    Gus client instance.
+ * @param[in] ctx    Network and application key, TTL and destination,
+ *                   typically the group all badges subscribe to.
+ * @param[in] base   Unicast address of the first badge.
+ * @param[in] states State of badge base + i, enum bt_mesh_gus_state or
+ *                   BT_MESH_GUS_STATE_UNCHANGED.
+ * @param[in] count  Number of entries in @p states.
+ *
+ * @retval 0       The message was sent.
+ * @retval -EINVAL More than BT_MESH_GUS_SET_STATES_MAX states.
+ * @return Other negative error codes from bt_mesh_model_send().
+ */
+int bt_mesh_gus_cli_set_states(struct bt_mesh_gus_cli *cli,
+			       struct bt_mesh_msg_ctx *ctx, uint16_t base,
+			       const uint8_t *states, size_t count);
+
+/** @brief Stop the running collection, without calling done.
+ *
+ * @param[in] cli Gus client instance.
+ */
+void bt_mesh_gus_cli_cancel(struct bt_mesh_gus_cli *cli);
+
+/** @brief Check whether a collection is running.
+ *
+ * @param[in] cli Gus client instance.
+ *
+ * @return true while a collection is running.
+ */
+bool bt_mesh_gus_cli_busy(struct bt_mesh_gus_cli *cli);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BT_MESH_GUS_CLI_H__ */
@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <fs/fcb.h>
+#include <storage/flash_map.h>
+#include <logging/log.h>
+#include "gus_contact_log.h"
+#include "gus_neighbors.h"
+
+LOG_MODULE_DECLARE(gus);
+
+#ifdef CONFIG_GUS_CONTACT_LOG
+
+#define LOG_AREA    FLASH_AREA_ID(contact_log)
+#define LOG_MAGIC   0x47555343           // "GUSC"
+#define LOG_VERSION 1
+#define BATCH       CONFIG_GUS_CONTACT_LOG_BATCH
+
+static struct flash_sector sectors[CONFIG_GUS_CONTACT_LOG_SECTORS];
+static struct fcb fcb;
+static bool ready;
+static uint16_t boot;
+static uint32_t next_seq = 1;
+static uint32_t last_seq;               // newest record in flash
+
+static struct k_spinlock lock;
+static struct gus_contact_record pending[BATCH];
+static size_t pending_len;
+static struct k_work_delayable flush_work;
+static atomic_t dropped;
+
+// contacts reported in the last round, with their contact time at the
+// last record; only touched by the end of a proximity round
+static struct {
+	uint16_t addr;
+	int8_t rssi;
+	uint8_t confidence;
+	uint8_t band;
+	uint16_t seconds[BT_MESH_GUS_EXPOSURE_BANDS];
+} active[NUM_PROXIMITY_REPORTS];
+static size_t active_len;
+
+static const int8_t band_rssi[BT_MESH_GUS_EXPOSURE_BANDS] = {
+	CONFIG_GUS_EXPOSURE_RSSI_NEAR,
+	CONFIG_GUS_EXPOSURE_RSSI_MID,
+	CONFIG_GUS_EXPOSURE_RSSI_FAR,
+};
+
+// where the last read stopped, so paging does not rescan the whole log
+static struct {
+	struct k_mutex mutex;
+	uint32_t seq;
+	uint32_t rotations;
+	struct fcb_entry loc;
+} resume;
+static atomic_t rotations;
+
+/////////////////////
+// Static functions
+/////////////////////
+
+static int read_record(struct fcb_entry *loc,
+		       struct gus_contact_record *record)
+{
+	if (loc->fe_data_len != sizeof(*record)) {
+		return -EINVAL;
+	}
+
+	return flash_area_read(fcb.fap, FCB_ENTRY_FA_DATA_OFF(*loc), record,
+			       sizeof(*record));
+}
+
+static int write_record(const struct gus_contact_record *record)
+{
+	struct fcb_entry loc;
+	int err;
+
+	err = fcb_append(&fcb, sizeof(*record), &loc);
+	if (err == -ENOSPC) {
+		// out of space, drop the oldest sector
+		atomic_inc(&rotations);
+		err = fcb_rotate(&fcb);
+		if (!err) {
+			err = fcb_append(&fcb, sizeof(*record), &loc);
+		}
+	}
+	if (err) {
+		return err;
+	}
+
+	err = flash_area_write(fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), record,
+			       sizeof(*record));
+	if (err) {
+		return err;
+	}
+
+	err = fcb_append_finish(&fcb, &loc);
+	if (!err) {
+		last_seq = record->seq;
+	}
+
+	return err;
+}
+
+// put records that were not written back in front of the batch, the
+// oldest of them give way when it is full
+static void requeue(const struct gus_contact_record *records, size_t len)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	size_t keep = MIN(len, BATCH - pending_len);
+
+	memmove(&pending[keep], pending, pending_len * sizeof(pending[0]));
+	memcpy(pending, &records[len - keep], keep * sizeof(pending[0]));
+	pending_len += keep;
+	k_spin_unlock(&lock, key);
+
+	atomic_add(&dropped, len - keep);
+	k_work_schedule(&flush_work, K_MSEC(CONFIG_GUS_CONTACT_LOG_FLUSH_MS));
+}
+
+static void flush_handler(struct k_work *work)
+{
+	static struct gus_contact_record batch[BATCH];
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	size_t len = pending_len;
+
+	memcpy(batch, pending, len * sizeof(batch[0]));
+	pending_len = 0;
+	k_spin_unlock(&lock, key);
+
+	for (size_t i = 0; i < len; ++i) {
+		int err = write_record(&batch[i]);
+
+		if (err) {
+			LOG_ERR("Contact log write failed (err %d)", err);
+			requeue(&batch[i], len - i);
+			return;
+		}
+	}
+}
+
+static uint8_t rssi_band(int8_t rssi)
+{
+	uint8_t band = 0;
+
+	while (band < BT_MESH_GUS_EXPOSURE_BANDS && rssi < band_rssi[band]) {
+		band++;
+	}
+
+	return band;
+}
+
+static bool is_active(uint16_t addr)
+{
+	for (size_t i = 0; i < active_len; ++i) {
+		if (active[i].addr == addr) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// log the contact time of an active contact since its last record
+static void log_contact(size_t i)
+{
+	struct gus_exposure_data exposure = { 0 };
+	struct gus_contact_record record = {
+		.addr = active[i].addr,
+		.rssi = active[i].rssi,
+		.confidence = active[i].confidence,
+	};
+
+	(void)gus_neighbors_find(active[i].addr, &exposure);
+
+	for (int band = 0; band < BT_MESH_GUS_EXPOSURE_BANDS; ++band) {
+		// the neighbor table was reset in between
+		if (exposure.seconds[band] < active[i].seconds[band]) {
+			active[i].seconds[band] = 0;
+		}
+		record.seconds[band] = exposure.seconds[band] -
+				       active[i].seconds[band];
+		active[i].seconds[band] = exposure.seconds[band];
+	}
+
+	(void)gus_contact_log_add(&record);
+}
+
+static int open_log(void)
+{
+	uint32_t cnt = ARRAY_SIZE(sectors);
+	int err;
+
+	err = flash_area_get_sectors(LOG_AREA, &cnt, sectors);
+	if (err) {
+		return err;
+	}
+
+	fcb.f_magic = LOG_MAGIC;
+	fcb.f_version = LOG_VERSION;
+	fcb.f_sectors = sectors;
+	fcb.f_sector_cnt = cnt;
+	fcb.f_scratch_cnt = 0;
+
+	return fcb_init(LOG_AREA, &fcb);
+}
+
+static int erase_log(void)
+{
+	const struct flash_area *fa;
+	int err;
+
+	err = flash_area_open(LOG_AREA, &fa);
+	if (err) {
+		return err;
+	}
+
+	err = flash_area_erase(fa, 0, fa->fa_size);
+	flash_area_close(fa);
+
+	return err;
+}
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+int gus_contact_log_init(void)
+{
+	struct gus_contact_record record;
+	struct fcb_entry loc = { 0 };
+	int err;
+
+	err = open_log();
+	if (err) {
+		// not a contact log (or a different version), start over
+		LOG_WRN("Contact log reset (err %d)", err);
+		err = erase_log();
+		if (!err) {
+			err = open_log();
+		}
+		if (err) {
+			return err;
+		}
+	}
+
+	while (!fcb_getnext(&fcb, &loc)) {
+		if (!read_record(&loc, &record)) {
+			last_seq = MAX(last_seq, record.seq);
+			boot = MAX(boot, record.boot);
+		}
+	}
+
+	boot++;
+	next_seq = last_seq + 1;
+
+	k_mutex_init(&resume.mutex);
+	k_work_init_delayable(&flush_work, flush_handler);
+	ready = true;
+
+	LOG_INF("Contact log boot %u, last record %u", boot, last_seq);
+
+	return 0;
+}
+
+int gus_contact_log_add(struct gus_contact_record *record)
+{
+	k_spinlock_key_t key;
+	size_t len;
+
+	if (!ready) {
+		return -EAGAIN;
+	}
+
+	key = k_spin_lock(&lock);
+	if (pending_len == BATCH) {
+		k_spin_unlock(&lock, key);
+		atomic_inc(&dropped);
+		return -ENOMEM;
+	}
+
+	record->seq = next_seq++;
+	record->boot = boot;
+	record->time = k_uptime_get_32() / MSEC_PER_SEC;
+	pending[pending_len++] = *record;
+	len = pending_len;
+	k_spin_unlock(&lock, key);
+
+	if (len == BATCH) {
+		k_work_reschedule(&flush_work, K_NO_WAIT);
+	} else {
+		// no-op if a flush is already scheduled
+		k_work_schedule(&flush_work,
+				K_MSEC(CONFIG_GUS_CONTACT_LOG_FLUSH_MS));
+	}
+
+	return 0;
+}
+
+size_t gus_contact_log_read(uint32_t after, struct gus_contact_record *records,
+			    size_t max)
+{
+	struct fcb_entry loc = { 0 };
+	uint32_t rotated;
+	size_t len = 0;
+
+	if (!ready || max == 0) {
+		return 0;
+	}
+
+	k_mutex_lock(&resume.mutex, K_FOREVER);
+
+	// a rotation during the walk invalidates the resume point
+	rotated = atomic_get(&rotations);
+	if (after != 0 && after == resume.seq && resume.rotations == rotated) {
+		loc = resume.loc;
+	}
+
+	while (len < max && !fcb_getnext(&fcb, &loc)) {
+		if (read_record(&loc, &records[len]) ||
+		    records[len].seq <= after) {
+			continue;
+		}
+
+		resume.seq = records[len].seq;
+		resume.loc = loc;
+		len++;
+	}
+	resume.rotations = rotated;
+
+	k_mutex_unlock(&resume.mutex);
+
+	return len;
+}
+
+uint32_t gus_contact_log_last(void)
+{
+	return last_seq;
+}
+
+void gus_contact_log_round(const struct gus_report_data *contacts,
+			   size_t count)
+{
+	size_t i = active_len;
+
+	// contacts that ended or changed band since the last round
+	while (i-- > 0) {
+		size_t j = 0;
+
+		while (j < count && contacts[j].addr != active[i].addr) {
+			j++;
+		}
+
+		if (j == count) {
+			log_contact(i);
+			active[i] = active[--active_len];
+			continue;
+		}
+
+		if (rssi_band(contacts[j].rssi) != active[i].band) {
+			log_contact(i);
+			active[i].band = rssi_band(contacts[j].rssi);
+		}
+		active[i].rssi = contacts[j].rssi;
+		active[i].confidence = contacts[j].confidence;
+	}
+
+	// contacts that started
+	for (size_t j = 0; j < count && active_len < ARRAY_SIZE(active); ++j) {
+		struct gus_exposure_data exposure = { 0 };
+
+		if (is_active(contacts[j].addr)) {
+			continue;
+		}
+
+		(void)gus_neighbors_find(contacts[j].addr, &exposure);
+		active[active_len].addr = contacts[j].addr;
+		active[active_len].rssi = contacts[j].rssi;
+		active[active_len].confidence = contacts[j].confidence;
+		active[active_len].band = rssi_band(contacts[j].rssi);
+		memcpy(active[active_len].seconds, exposure.seconds,
+		       sizeof(exposure.seconds));
+		active_len++;
+	}
+}
+
+uint32_t gus_contact_log_dropped(void)
+{
+	return atomic_get(&dropped);
+}
+
+#else
+
+int gus_contact_log_init(void)
+{
+	return 0;
+}
+
+int gus_contact_log_add(struct gus_contact_record *record)
+{
+	return -ENOTSUP;
+}
+
+size_t gus_contact_log_read(uint32_t after, struct gus_contact_record *records,
+			    size_t max)
+{
+	return 0;
+}
+
+uint32_t gus_contact_log_last(void)
+{
+	return 0;
+}
+
+void gus_contact_log_round(const struct gus_report_data *contacts,
+			   size_t count)
+{
+}
+
+uint32_t gus_contact_log_dropped(void)
+{
+	return 0;
+}
+
+#endif /* CONFIG_GUS_CONTACT_LOG */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus contact log
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// Contact log - append only log of the reported contacts, kept in a flash
+// circular buffer (FCB) in the contact_log partition.
+//
+// A contact is logged when it ends, that is when the neighbor is no longer
+// among the reported contacts of a round, and when its smoothed rssi moves
+// to another exposure band.  Each record carries the contact time since
+// the previous record of the same contact, so a steady room writes next to
+// nothing and the partition holds hours of contacts.
+//
+// Records are numbered with a sequence number that continues across
+// resets, collected in RAM, and written in batches from the system work
+// queue.  Records a failed write left behind are tried again with the next
+// batch.  When the partition is full the oldest sector is dropped.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GUS_CONTACT_LOG_H__
+#define GUS_CONTACT_LOG_H__
+
+#include <zephyr/types.h>
+#include "gus_svr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Open the contact log and find the newest record.
+ *
+ *  @retval 0           If the operation was successful.
+ *                      Otherwise, a (negative) error code is returned.
+ */
+int gus_contact_log_init(void);
+
+/** @brief Append a record.
+ *
+ *  Fills in the sequence number, boot count and time of the record and
+ *  queues it for the next flash write.
+ *
+ *  @param record Contact to log.
+ *
+ *  @retval 0        The record is queued.
+ *  @retval -EAGAIN  The log is not initialized.
+ *  @retval -ENOMEM  The RAM batch is full, the record is dropped.
+ */
+int gus_contact_log_add(struct gus_contact_record *record);
+
+/** @brief Read the records that follow a sequence number.
+ *
+ *  Only records already written to flash are returned.
+ *
+ *  @param after   Sequence number of the last record the caller has.
+ *  @param records Destination of the records.
+ *  @param max     Number of entries in @p records.
+ *
+ *  @return Number of records copied to @p records.
+ */
+size_t gus_contact_log_read(uint32_t after, struct gus_contact_record *records,
+			    size_t max);
+
+/** @brief Sequence number of the newest record written to flash. */
+uint32_t gus_contact_log_last(void);
+
+/** @brief End a proximity round.
+ *
+ *  Logs the contacts that ended or changed exposure band since the last
+ *  round.  Called from one thread at a time.
+ *
+ *  @param contacts Contacts reported at the end of the round.
+ *  @param count    Number of entries in @p contacts.
+ */
+void gus_contact_log_round(const struct gus_report_data *contacts,
+			   size_t count);
+
+/** @brief Number of records dropped because the RAM batch was full. */
+uint32_t gus_contact_log_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_CONTACT_LOG_H__ */
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include "gus_core.h"
+
+#define ADDR_UNASSIGNED 0x0000
+
+static const char *const spare_names[] = {
+	"Anja",    "Birgit",  "Casper", "Dag",    "Eirik", "Fritjof",
+	"Gunvor",  "Hildur",  "Ingolf", "Ingolf", "Jorg",  "Kjerstin",
+	"Lisbet",  "Mikaela", "Niklas", "Oydis",  "Peder", "Ragnhild",
+};
+
+static uint8_t compact_rssi(int8_t rssi)
+{
+	int level = (rssi - BT_MESH_GUS_COMPACT_RSSI_MIN) /
+		    BT_MESH_GUS_COMPACT_RSSI_STEP;
+
+	return CLAMP(level, 0, BT_MESH_GUS_COMPACT_RSSI_MASK);
+}
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+size_t gus_core_compact_encode(uint16_t own_addr,
+			       const struct gus_report_data *report,
+			       size_t count, uint8_t *out)
+{
+	size_t len = 1;
+
+	out[0] = 0;
+	for (size_t i = 0; i < MIN(count, NUM_PROXIMITY_REPORTS); ++i) {
+		if (report[i].addr == ADDR_UNASSIGNED) {
+			continue;
+		}
+
+		int32_t delta = (int32_t)report[i].addr - own_addr;
+		uint8_t rssi = compact_rssi(report[i].rssi) |
+			       ((report[i].confidence
+				 << BT_MESH_GUS_COMPACT_CONF_SHIFT) &
+				BT_MESH_GUS_COMPACT_CONF_MASK);
+
+		if (delta >= INT8_MIN && delta <= INT8_MAX) {
+			out[len++] = rssi;
+			out[len++] = (uint8_t)(int8_t)delta;
+		} else {
+			out[len++] = rssi | BT_MESH_GUS_COMPACT_LONG_ADDR;
+			out[len++] = report[i].addr & 0xff;
+			out[len++] = report[i].addr >> 8;
+		}
+		out[0]++;
+	}
+
+	return len;
+}
+
+int gus_core_compact_decode(uint16_t reporter, const uint8_t *data,
+			    size_t len, struct gus_report_data *report,
+			    size_t max)
+{
+	size_t pos = 1;
+	int count = 0;
+
+	if (len < 1) {
+		return -1;
+	}
+
+	for (uint8_t i = 0; i < data[0]; ++i) {
+		if (pos + 2 > len) {
+			return -1;
+		}
+
+		uint8_t rssi = data[pos++];
+		uint16_t addr;
+
+		if (rssi & BT_MESH_GUS_COMPACT_LONG_ADDR) {
+			if (pos + 2 > len) {
+				return -1;
+			}
+			addr = data[pos] | (data[pos + 1] << 8);
+			pos += 2;
+		} else {
+			addr = reporter + (int8_t)data[pos++];
+		}
+
+		if ((size_t)count < max) {
+			report[count].addr = addr;
+			report[count].rssi = BT_MESH_GUS_COMPACT_RSSI(rssi);
+			report[count].confidence =
+				(rssi & BT_MESH_GUS_COMPACT_CONF_MASK) >>
+				BT_MESH_GUS_COMPACT_CONF_SHIFT;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+const char *gus_core_sign_in_name(const char *name, uint16_t addr)
+{
+	if (name[0] != '\0') {
+		return name;
+	}
+
+	return spare_names[addr % ARRAY_SIZE(spare_names)];
+}
+
+uint16_t gus_core_name_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash = (hash ^ (uint8_t)*name++) * 16777619u;
+	}
+
+	// xor folding, as recommended for FNV hashes shorter than 32 bits
+	return (hash >> 16) ^ (hash & 0xffff);
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus proximity core
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// Proximity core - the parts of the badge that do not talk to the mesh.
+// The report and exposure data types, the compact report encoding and the
+// sign-in name selection live here, next to the neighbor table
+// (gus_neighbors.h).  None of it depends on Zephyr, so the same sources
+// are built on the host by host/CMakeLists.txt and timed there.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GUS_CORE_H__
+#define GUS_CORE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __ZEPHYR__
+#include <sys/util.h>
+#else
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#define CLAMP(val, low, high) \
+	(((val) <= (low)) ? (low) : MIN(val, high))
+#define BIT(n) (1UL << (n))
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+#define BUILD_ASSERT(expr, msg) _Static_assert(expr, msg)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUM_PROXIMITY_REPORTS 6             // number of proximity records
+                                            // sent in a message
+
+/** Confidence of a proximity report entry. */
+enum bt_mesh_gus_confidence {
+	BT_MESH_GUS_CONFIDENCE_NONE,
+	BT_MESH_GUS_CONFIDENCE_LOW,
+	BT_MESH_GUS_CONFIDENCE_MEDIUM,
+	BT_MESH_GUS_CONFIDENCE_HIGH,
+};
+
+struct gus_report_data {
+    uint16_t addr;
+    int8_t rssi;             // smoothed rssi
+    uint8_t confidence;      // enum bt_mesh_gus_confidence
+    }; 
+
+//////////////////////////////////////////////////////////////////////////////
+// Compact report reply format:
+//    count (1 byte), followed by count entries of
+//    rssi  (1 byte)  bits 0-4 quantized rssi level, see below
+//                    bits 5-6 enum bt_mesh_gus_confidence
+//                    bit  7   set if a full 16 bit address follows
+//    addr  (1 byte)  signed address delta against the reporting badge, or
+//          (2 bytes) little endian unicast address if bit 7 is set
+//
+// Only valid entries are sent, so a report with up to three neighbors fits
+// in a single unsegmented access message.
+//////////////////////////////////////////////////////////////////////////////
+#define BT_MESH_GUS_COMPACT_RSSI_MIN   -100  // rssi of level 0
+#define BT_MESH_GUS_COMPACT_RSSI_STEP  2     // dB per level
+#define BT_MESH_GUS_COMPACT_RSSI_MASK  0x1f
+#define BT_MESH_GUS_COMPACT_CONF_SHIFT 5
+#define BT_MESH_GUS_COMPACT_CONF_MASK  0x60
+#define BT_MESH_GUS_COMPACT_LONG_ADDR  BIT(7)
+#define BT_MESH_GUS_COMPACT_RSSI(level) (BT_MESH_GUS_COMPACT_RSSI_MIN + \
+	((level) & BT_MESH_GUS_COMPACT_RSSI_MASK) * BT_MESH_GUS_COMPACT_RSSI_STEP)
+#define BT_MESH_GUS_MSG_MAXLEN_REPORT_COMPACT_REPLY \
+				(1 + NUM_PROXIMITY_REPORTS * 3)
+
+/** Number of rssi bands contact time is accumulated in. */
+#define BT_MESH_GUS_EXPOSURE_BANDS 3
+
+/** Contact time with one neighbor. */
+struct gus_exposure_data {
+	uint16_t addr;
+	/** Seconds at or above the near, mid and far rssi levels. */
+	uint16_t seconds[BT_MESH_GUS_EXPOSURE_BANDS];
+};
+
+/** @brief Encode a compact report.
+ *
+ *  Only the first NUM_PROXIMITY_REPORTS entries of @p report are encoded.
+ *
+ *  @param own_addr Unicast address of the reporting badge.
+ *  @param report   Report entries, strongest first.
+ *  @param count    Number of valid entries in @p report.
+ *  @param out      Buffer of at least
+ *                  BT_MESH_GUS_MSG_MAXLEN_REPORT_COMPACT_REPLY bytes.
+ *
+ *  @return Number of bytes written to @p out.
+ */
+size_t gus_core_compact_encode(uint16_t own_addr,
+			       const struct gus_report_data *report,
+			       size_t count, uint8_t *out);
+
+/** @brief Decode a compact report.
+ *
+ *  @param reporter Unicast address of the badge that sent the report.
+ *  @param data     Compact report, starting with the entry count.
+ *  @param len      Length of @p data.
+ *  @param report   Decoded entries. The rssi is the lower bound of the
+ *                  quantized level.
+ *  @param max      Size of @p report.
+ *
+ *  @return Number of entries decoded, or -1 if @p data is malformed.
+ */
+int gus_core_compact_decode(uint16_t reporter, const uint8_t *data,
+			    size_t len, struct gus_report_data *report,
+			    size_t max);
+
+/** @brief Get the name a badge signs in with.
+ *
+ *  @param name Name set by the client, may be empty.
+ *  @param addr Unicast address of the badge.
+ *
+ *  @return @p name, or a spare name picked from @p addr if @p name is
+ *          empty.
+ */
+const char *gus_core_sign_in_name(const char *name, uint16_t addr);
+
+/** @brief Hash a badge name for the status message.
+ *
+ *  16 bit FNV-1a, so a client can tell whether the name it knows is
+ *  still current without asking for it.
+ *
+ *  @param name Name, nul terminated.
+ *
+ *  @return Hash of @p name.
+ */
+uint16_t gus_core_name_hash(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_CORE_H__ */
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <bluetooth/mesh.h>
+#include "gus_energy.h"
+
+#ifdef CONFIG_GUS_ENERGY
+
+#define UNSEG_MAX     11      // access payload of an unsegmented message
+#define SEG_LEN       12      // access payload per segment
+#define MIC_LEN       4       // transport MIC of a segmented message
+#define MS_PER_HOUR   3600000ULL
+
+static struct k_spinlock lock;
+static uint64_t tx_us;
+static uint32_t tx_count;
+static uint64_t scan_ms;
+static uint64_t led_ms_permille;
+static uint32_t led_permille;
+static bool scanning = true;
+static int64_t scan_since;
+static int64_t leds_since;
+
+// add the time since the last change to the running totals
+static void accumulate(int64_t now)
+{
+	if (scanning) {
+		scan_ms += now - scan_since;
+	}
+	scan_since = now;
+
+	led_ms_permille += (uint64_t)(now - leds_since) * led_permille;
+	leds_since = now;
+}
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+void gus_energy_tx(size_t len)
+{
+	uint8_t xmit = bt_mesh_net_transmit_get();
+	uint32_t pdus = 1;
+
+	if (len > UNSEG_MAX) {
+		pdus = DIV_ROUND_UP(len + MIC_LEN, SEG_LEN);
+	}
+
+	uint32_t events = pdus * (BT_MESH_TRANSMIT_COUNT(xmit) + 1);
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	tx_count += events;
+	tx_us += events * CONFIG_GUS_ENERGY_ADV_EVENT_US;
+	k_spin_unlock(&lock, key);
+}
+
+void gus_energy_scan(bool on)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	accumulate(k_uptime_get());
+	scanning = on;
+	k_spin_unlock(&lock, key);
+}
+
+void gus_energy_leds(uint32_t permille)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	accumulate(k_uptime_get());
+	led_permille = permille;
+	k_spin_unlock(&lock, key);
+}
+
+void gus_energy_get(struct gus_energy *energy)
+{
+	int64_t now = k_uptime_get();
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	accumulate(now);
+
+	uint64_t led_ms = led_ms_permille / 1000;
+	uint64_t tx_ms = tx_us / 1000;
+	uint64_t ua_ms = tx_ms * CONFIG_GUS_ENERGY_TX_UA +
+			 scan_ms * CONFIG_GUS_ENERGY_RX_UA +
+			 led_ms * CONFIG_GUS_ENERGY_LED_UA +
+			 (uint64_t)now * CONFIG_GUS_ENERGY_IDLE_UA;
+
+	energy->uptime_s = now / MSEC_PER_SEC;
+	energy->tx_count = tx_count;
+	energy->tx_ms = tx_ms;
+	energy->scan_s = scan_ms / MSEC_PER_SEC;
+	energy->led_ms = MIN(led_ms, UINT32_MAX);
+	energy->charge_uah = ua_ms / MS_PER_HOUR;
+	k_spin_unlock(&lock, key);
+}
+
+#else
+
+void gus_energy_tx(size_t len)
+{
+}
+
+void gus_energy_scan(bool on)
+{
+}
+
+void gus_energy_leds(uint32_t permille)
+{
+}
+
+void gus_energy_get(struct gus_energy *energy)
+{
+	memset(energy, 0, sizeof(*energy));
+}
+
+#endif /* CONFIG_GUS_ENERGY */
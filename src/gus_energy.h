@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus energy accounting
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// Energy accounting - an estimate of where the battery charge goes.
+//
+// The badge does not measure its current.  Instead it counts what it does
+// and multiplies that by typical currents from Kconfig:
+//   tx    - radio transmissions of Gus messages.  Every network PDU is sent
+//           network transmit count + 1 times, each time as one advertising
+//           event of CONFIG_GUS_ENERGY_ADV_EVENT_US on-air time, and long
+//           messages are split into segments.
+//   scan  - the time the radio listens.  A mesh node scans all the time,
+//           except while a Low Power Node has a friend.
+//   leds  - LED-on time, from the LED driver.
+//   idle  - everything else, as a constant current.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GUS_ENERGY_H__
+#define GUS_ENERGY_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Energy counters since boot. */
+struct gus_energy {
+	uint32_t uptime_s;
+	/** Advertising events sent for Gus messages. */
+	uint32_t tx_count;
+	/** Estimated radio transmit time. */
+	uint32_t tx_ms;
+	/** Time spent scanning. */
+	uint32_t scan_s;
+	/** LED-on time, in milliseconds of one LED at full brightness. */
+	uint32_t led_ms;
+	/** Estimated charge consumed. */
+	uint32_t charge_uah;
+};
+
+/** @brief Count the transmission of a message.
+ *
+ *  @param len Length of the access message, opcode included.
+ */
+void gus_energy_tx(size_t len);
+
+/** @brief Note that scanning started or stopped.
+ *
+ *  @param on true while the radio scans continuously.
+ */
+void gus_energy_scan(bool on);
+
+/** @brief Note a change of the LEDs.
+ *
+ *  @param permille LEDs that are on, in thousandths of one LED at full
+ *                  brightness.
+ */
+void gus_energy_leds(uint32_t permille);
+
+/** @brief Read the energy counters.
+ *
+ *  @param energy Counters, with the charge estimate up to now.
+ */
+void gus_energy_get(struct gus_energy *energy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_ENERGY_H__ */
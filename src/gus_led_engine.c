@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include "gus_leds.h"
+#include "gus_led_engine.h"
+
+#define CHASE_LEDS 6
+
+struct led_layer {
+	bool active;
+	bool chase;
+	uint32_t leds;          // static pattern
+	uint16_t steps;         // chase steps left, or GUS_LED_FOREVER
+	uint16_t interval_ms;
+	uint8_t step;           // LED lit by the chase
+};
+
+static struct led_layer layers[GUS_LED_LAYER_COUNT];
+static struct k_spinlock lock;
+static struct k_work_delayable render_work;
+
+/////////////////////
+// Static functions
+/////////////////////
+
+static struct led_layer *top_layer(void)
+{
+	for (int i = GUS_LED_LAYER_COUNT - 1; i >= 0; --i) {
+		if (layers[i].active) {
+			return &layers[i];
+		}
+	}
+
+	return NULL;
+}
+
+// show the top layer, advance its animation and decide when to run again
+static void render_handler(struct k_work *work)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct led_layer *layer = top_layer();
+	uint32_t leds = DK_NO_LEDS_MSK;
+	k_timeout_t next = K_FOREVER;
+
+	if (layer && !layer->chase) {
+		leds = layer->leds;
+	} else if (layer) {
+		leds = BIT(layer->step);
+		layer->step = (layer->step + 1) % CHASE_LEDS;
+		next = K_MSEC(layer->interval_ms);
+
+		if (layer->steps != GUS_LED_FOREVER && --layer->steps == 0) {
+			layer->active = false;
+		}
+	}
+	k_spin_unlock(&lock, key);
+
+	(void)gus_set_leds(leds);
+
+	if (!K_TIMEOUT_EQ(next, K_FOREVER)) {
+		k_work_reschedule(&render_work, next);
+	}
+}
+
+static void render(void)
+{
+	k_work_reschedule(&render_work, K_NO_WAIT);
+}
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+void gus_led_engine_init(void)
+{
+	k_work_init_delayable(&render_work, render_handler);
+}
+
+void gus_led_engine_set(enum gus_led_layer layer, uint32_t leds)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	layers[layer].active = true;
+	layers[layer].chase = false;
+	layers[layer].leds = leds;
+	k_spin_unlock(&lock, key);
+
+	render();
+}
+
+void gus_led_engine_chase(enum gus_led_layer layer, uint16_t steps,
+			  uint16_t interval_ms)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	layers[layer].active = true;
+	layers[layer].chase = true;
+	layers[layer].steps = steps;
+	layers[layer].interval_ms = interval_ms;
+	layers[layer].step = 0;
+	k_spin_unlock(&lock, key);
+
+	render();
+}
+
+void gus_led_engine_clear(enum gus_led_layer layer)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	layers[layer].active = false;
+	k_spin_unlock(&lock, key);
+
+	render();
+}
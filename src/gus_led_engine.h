@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus LED engine
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// LED engine - owns the badge LEDs.
+//
+// Every user of the LEDs draws on its own layer, and the highest active
+// layer is shown.  A layer is either a static pattern or a chase animation
+// that steps one LED at a time.  All GPIO writes happen from a single
+// delayable work item on the system work queue, which is only scheduled
+// while an animation runs, so the LEDs cost no CPU time when they are
+// static and the kernel can stay idle.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GUS_LED_ENGINE_H__
+#define GUS_LED_ENGINE_H__
+
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Run an animation until its layer is cleared. */
+#define GUS_LED_FOREVER 0
+
+/** LED layers, a higher layer hides the ones below it. */
+enum gus_led_layer {
+	/** Health state of the badge. */
+	GUS_LED_LAYER_HEALTH,
+	/** Identify state set by the client. */
+	GUS_LED_LAYER_IDENTIFY,
+	/** Health server attention timer. */
+	GUS_LED_LAYER_ATTENTION,
+
+	GUS_LED_LAYER_COUNT,
+};
+
+/** @brief Initialize the LED engine.
+ *
+ *  The LED driver must be initialized with gus_leds_init() first.
+ */
+void gus_led_engine_init(void);
+
+/** @brief Show a static LED pattern on a layer.
+ *
+ *  @param layer Layer to draw on.
+ *  @param leds  Bitmask of the LEDs to turn on.
+ */
+void gus_led_engine_set(enum gus_led_layer layer, uint32_t leds);
+
+/** @brief Run a chase animation on a layer.
+ *
+ *  One LED is on at a time, moving to the next LED every @p interval_ms.
+ *  When the animation is done the layer is cleared.
+ *
+ *  @param layer       Layer to draw on.
+ *  @param steps       Number of steps, or GUS_LED_FOREVER.
+ *  @param interval_ms Time between two steps.
+ */
+void gus_led_engine_chase(enum gus_led_layer layer, uint16_t steps,
+			  uint16_t interval_ms);
+
+/** @brief Clear a layer, showing the layers below it.
+ *
+ *  @param layer Layer to clear.
+ */
+void gus_led_engine_clear(enum gus_led_layer layer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_LED_ENGINE_H__ */
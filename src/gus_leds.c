@@ -8,10 +8,12 @@
 #include <soc.h>
 #include <device.h>
 #include <drivers/gpio.h>
+#include <string.h>
 #include <sys/util.h>
 #include <logging/log.h>
 #include <nrfx.h>
 #include "gus_leds.h"
+#include "gus_energy.h"
 
 LOG_MODULE_REGISTER(gus_leds, CONFIG_DK_LIBRARY_LOG_LEVEL);
 
@@ -54,30 +56,64 @@ enum state {
 	STATE_SCANNING,
 };
 
+#define LED_PATTERNS BIT(ARRAY_SIZE(led_pins))
 
-static const struct device *led_devs[ARRAY_SIZE(led_pins)];
-
-
+static const struct device *led_port;
+static gpio_port_pins_t led_port_mask;
+static gpio_port_value_t led_polarity;
+// port bits of every combination of LEDs, indexed by LED bitmask
+static gpio_port_value_t led_patterns[LED_PATTERNS];
+// LEDs that are on, for the energy accounting
+static uint32_t leds_lit;
 
+static void leds_changed(void)
+{
+	gus_energy_leds(__builtin_popcount(leds_lit) * 1000);
+}
 
 
 int gus_leds_init(void)
 {
 	int err;
 
+	if (ARRAY_SIZE(led_pins) == 0) {
+		return 0;
+	}
+
+	led_port = device_get_binding(led_pins[0].port);
+	if (!led_port) {
+		LOG_ERR("Cannot bind gpio device");
+		return -ENODEV;
+	}
+
 	for (size_t i = 0; i < ARRAY_SIZE(led_pins); i++) {
-		led_devs[i] = device_get_binding(led_pins[i].port);
-		if (!led_devs[i]) {
-			LOG_ERR("Cannot bind gpio device");
-			return -ENODEV;
+		// the whole pattern is written to one port at once
+		if (strcmp(led_pins[i].port, led_pins[0].port) != 0) {
+			LOG_ERR("LEDs must be on one gpio port");
+			return -ENOTSUP;
 		}
 
-		err = gpio_pin_configure(led_devs[i], led_pins[i].number,
+		err = gpio_pin_configure(led_port, led_pins[i].number,
 					 GPIO_OUTPUT);
 		if (err) {
 			LOG_ERR("Cannot configure LED gpio");
 			return err;
 		}
+
+		led_port_mask |= BIT(led_pins[i].number);
+	}
+
+	if (IS_ENABLED(CONFIG_DK_LIBRARY_INVERT_LEDS)) {
+		led_polarity = led_port_mask;
+	}
+
+	for (uint32_t leds = 0; leds < LED_PATTERNS; leds++) {
+		led_patterns[leds] = 0;
+		for (size_t i = 0; i < ARRAY_SIZE(led_pins); i++) {
+			if (leds & BIT(i)) {
+				led_patterns[leds] |= BIT(led_pins[i].number);
+			}
+		}
 	}
 
 	return gus_set_leds_state(DK_NO_LEDS_MSK, DK_ALL_LEDS_MSK);
@@ -95,40 +131,37 @@ int gus_set_leds_state(uint32_t leds_on_mask, uint32_t leds_off_mask)
 		return -EINVAL;
 	}
 
-	for (size_t i = 0; i < ARRAY_SIZE(led_pins); i++) {
-		if ((BIT(i) & leds_on_mask) || (BIT(i) & leds_off_mask)) {
-			uint32_t val = (BIT(i) & leds_on_mask) ? (1) : (0);
+	if (!led_port) {
+		return 0;
+	}
 
-			if (IS_ENABLED(CONFIG_DK_LIBRARY_INVERT_LEDS)) {
-				val = 1 - val;
-			}
+	// on has priority over off, and only the masked pins are written
+	gpio_port_pins_t mask = led_patterns[(leds_on_mask | leds_off_mask) &
+					     (LED_PATTERNS - 1)];
+	gpio_port_value_t value = led_patterns[leds_on_mask &
+					       (LED_PATTERNS - 1)];
 
-			int err = gpio_pin_set_raw(led_devs[i],
-						   led_pins[i].number, val);
-			if (err) {
-				LOG_ERR("Cannot write LED gpio");
-				return err;
-			}
-		}
+	int err = gpio_port_set_masked_raw(led_port, mask,
+					   value ^ led_polarity);
+	if (err) {
+		LOG_ERR("Cannot write LED gpio");
+		return err;
 	}
 
+	leds_lit = (leds_lit & ~(leds_on_mask | leds_off_mask)) | leds_on_mask;
+	leds_changed();
+
 	return 0;
 }
 
 int gus_set_led(uint8_t led_idx, uint32_t val)
 {
-	int err;
-
-	if (led_idx > ARRAY_SIZE(led_pins)) {
+	if (led_idx >= ARRAY_SIZE(led_pins)) {
 		LOG_ERR("LED index out of the range");
 		return -EINVAL;
 	}
-	err = gpio_pin_set_raw(led_devs[led_idx], led_pins[led_idx].number,
-		IS_ENABLED(CONFIG_DK_LIBRARY_INVERT_LEDS) ? !val : val);
-	if (err) {
-		LOG_ERR("Cannot write LED gpio");
-	}
-	return err;
+
+	return gus_set_leds_state(val ? BIT(led_idx) : 0, BIT(led_idx));
 }
 
 int gus_set_led_on(uint8_t led_idx)
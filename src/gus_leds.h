@@ -39,6 +39,10 @@ extern "C" {
 
 
 /** @brief Initialize the library to control the LEDs.
+ *
+ *  All LEDs must be on the same gpio port.  The port bits of every
+ *  combination of LEDs are computed here, so setting the LEDs is a single
+ *  masked port write.
  *
  *  @retval 0           If the operation was successful.
  *                      Otherwise, a (negative) error code is returned.
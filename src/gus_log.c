@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include "gus_log.h"
+
+#ifdef CONFIG_GUS_LOG_DROPPED
+
+#include <logging/log_backend.h>
+
+static atomic_t dropped;
+
+// the messages themselves are left to the console backend
+static void put(const struct log_backend *const backend, struct log_msg *msg)
+{
+}
+
+static void process(const struct log_backend *const backend,
+		    union log_msg2_generic *msg)
+{
+}
+
+static void drop(const struct log_backend *const backend, uint32_t cnt)
+{
+	atomic_add(&dropped, cnt);
+}
+
+static void panic(const struct log_backend *const backend)
+{
+}
+
+static const struct log_backend_api drop_counter_api = {
+	.put = IS_ENABLED(CONFIG_LOG2) ? NULL : put,
+	.process = IS_ENABLED(CONFIG_LOG2) ? process : NULL,
+	.dropped = drop,
+	.panic = panic,
+};
+
+LOG_BACKEND_DEFINE(gus_log_drop_counter, drop_counter_api, true);
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+uint32_t gus_log_dropped(void)
+{
+	return atomic_get(&dropped);
+}
+
+#else
+
+uint32_t gus_log_dropped(void)
+{
+	return 0;
+}
+
+#endif /* CONFIG_GUS_LOG_DROPPED */
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus dropped log message counter
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// The badge logs in deferred mode: a LOG_* call only stores its arguments,
+// and the log thread formats and prints them later.  When the log buffer
+// is full, the oldest messages are dropped instead of blocking the mesh.
+// With CONFIG_GUS_LOG_DROPPED a silent log backend counts those drops.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GUS_LOG_H__
+#define GUS_LOG_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Get the number of dropped log messages.
+ *
+ * @return Messages dropped since boot, 0 without CONFIG_GUS_LOG_DROPPED.
+ */
+uint32_t gus_log_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_LOG_H__ */
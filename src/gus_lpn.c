@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <bluetooth/mesh.h>
+#include <logging/log.h>
+#include "gus_lpn.h"
+#include "gus_energy.h"
+
+#ifdef CONFIG_GUS_LPN
+
+LOG_MODULE_DECLARE(gus);
+
+static bool lpn_enabled;
+static bool lpn_friend;
+
+static void lpn_established(uint16_t net_idx, uint16_t friend_addr,
+			    uint8_t queue_size, uint8_t recv_window)
+{
+	LOG_INF("lpn: friend 0x%04x, queue %d", friend_addr, queue_size);
+	lpn_friend = true;
+	// the radio only listens in the receive windows of a poll from now
+	gus_energy_scan(false);
+}
+
+static void lpn_terminated(uint16_t net_idx, uint16_t friend_addr)
+{
+	LOG_WRN("lpn: friend 0x%04x lost", friend_addr);
+	lpn_friend = false;
+	gus_energy_scan(true);
+}
+
+BT_MESH_LPN_CB_DEFINE(lpn_cb) = {
+	.established = lpn_established,
+	.terminated = lpn_terminated,
+};
+
+void gus_lpn_set(bool enable)
+{
+	int err = bt_mesh_lpn_set(enable);
+
+	if (err) {
+		LOG_ERR("lpn: set %d failed (err %d)", enable, err);
+		return;
+	}
+
+	lpn_enabled = enable;
+	if (!enable) {
+		lpn_friend = false;
+		gus_energy_scan(true);
+	}
+}
+
+void gus_lpn_toggle(void)
+{
+	gus_lpn_set(!lpn_enabled);
+}
+
+bool gus_lpn_established(void)
+{
+	return lpn_friend;
+}
+
+void gus_lpn_poll(void)
+{
+	if (lpn_friend) {
+		(void)bt_mesh_lpn_poll();
+	}
+}
+
+#else
+
+void gus_lpn_set(bool enable)
+{
+}
+
+void gus_lpn_toggle(void)
+{
+}
+
+bool gus_lpn_established(void)
+{
+	return false;
+}
+
+void gus_lpn_poll(void)
+{
+}
+
+#endif /* CONFIG_GUS_LPN */
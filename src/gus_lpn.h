@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus Low Power Node mode
+ */
+
+#ifndef GUS_LPN_H__
+#define GUS_LPN_H__
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Enable or disable Low Power Node mode.
+ *
+ *  @param enable true to look for a friend, false to scan continuously.
+ */
+void gus_lpn_set(bool enable);
+
+/** @brief Toggle Low Power Node mode. */
+void gus_lpn_toggle(void);
+
+/** @brief Check if messages are received through a friend.
+ *
+ *  @retval true A friendship is established, the rssi of received
+ *               messages is the rssi of the friend.
+ */
+bool gus_lpn_established(void);
+
+/** @brief Poll the friend for queued messages now. */
+void gus_lpn_poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_LPN_H__ */
@@ -7,64 +7,60 @@
 #include <bluetooth/bluetooth.h>
 #include <bluetooth/mesh/models.h>
 #include <dk_buttons_and_leds.h>
+#include "mesh/foundation.h"
 #include "gus_leds.h"
+#include "gus_led_engine.h"
 #include "gus_model_handler.h"
 #include "gus_svr.h"
+#include "gus_sweep.h"
+#include "gus_neighbors.h"
+#include "gus_contact_log.h"
+#include "gus_lpn.h"
+#include "gus_boot.h"
+#include "gus_spread.h"
+#include "gus_stream.h"
+#include "bsim/gus_bsim.h"
+#include <logging/log.h>
+#ifdef CONFIG_GUS_CLI
+#include "gus_cli.h"
+#endif
+
+LOG_MODULE_REGISTER(gus, CONFIG_GUS_LOG_LEVEL);
 
 #define PROXIMITY_TOO_CLOSE -85
 
-static struct gus_report_data dist_data[NUM_PROXIMITY_REPORTS];
-static int blinker = -1;
+#define IDENTIFY_STEPS       100
+#define LED_STEP_MS          100
 
-int get_blinker(void) 
-{
-    return blinker;
-}
 
-void set_blinker(int val) 
-{
-    blinker = val;
+///////////////////// PROCEDURES
+
+
+static void init_distance_data(void) {
+        gus_neighbors_reset();
 }
 
-int dec_blinker(void) 
+static void add_distance_data(uint16_t addr, int8_t rssi, uint8_t rttl)
 {
-    return --blinker;
+    (void)gus_neighbors_add(addr, rssi, k_uptime_get_32());
 }
 
+static void end_spread_round(void);
 
-///////////////////// PROCEDURES
+// log the contacts that ended or changed, then age the neighbors
+static void end_distance_round(void)
+{
+    struct gus_report_data dist_data[NUM_PROXIMITY_REPORTS];
+    size_t count = gus_neighbors_top(dist_data, NUM_PROXIMITY_REPORTS,
+                                     PROXIMITY_TOO_CLOSE + 1);
 
+    gus_contact_log_round(dist_data, count);
+    gus_neighbors_new_round();
 
-static void init_distance_data(void) {
-        for (int i=0; i < NUM_PROXIMITY_REPORTS; ++i) {
-                dist_data[i].addr = 0;
-                dist_data[i].rssi = -127;
-        }
-}
-static void add_distance_data(uint16_t addr, int8_t rssi, uint8_t rttl)
-{
-    if (rssi > PROXIMITY_TOO_CLOSE) {
-        // check for duplicate addresses
-        for (int i=0; i < NUM_PROXIMITY_REPORTS; ++i) {
-            if (dist_data[i].addr == addr) {
-                rssi = MAX(rssi, dist_data[i].rssi);
-                dist_data[i].rssi = -127;
-                break;
-            }
-        }
-        // insert into array in order of rssi
-        for (int i=0; i < NUM_PROXIMITY_REPORTS; ++i) {
-            if (rssi > dist_data[i].rssi) {
-                uint8_t ta = dist_data[i].addr;
-                int8_t  tr = dist_data[i].rssi;
-                dist_data[i].addr = addr;
-                dist_data[i].rssi = rssi;
-                addr = ta;
-                rssi = tr;
-            }
-        }
+    if (IS_ENABLED(CONFIG_GUS_SPREAD)) {
+        end_spread_round();
     }
- }
+}
 
 
 
@@ -81,45 +77,51 @@ static void add_distance_data(uint16_t addr, int8_t rssi, uint8_t rttl)
 
 static void display_health(enum bt_mesh_gus_state state)
 {
-printk("health: %d state\n", state);
-        set_blinker( state == BT_MESH_GUS_IDENTIFY ? 100 : -1);
-	if (state != BT_MESH_GUS_IDENTIFY) 
+        LOG_DBG("health: %d state", state);
+	if (state == BT_MESH_GUS_IDENTIFY) 
+        {
+            gus_led_engine_chase(GUS_LED_LAYER_IDENTIFY, IDENTIFY_STEPS,
+                                 LED_STEP_MS);
+        }
+        else
         {	   
+            gus_led_engine_clear(GUS_LED_LAYER_IDENTIFY);
+
             switch((uint16_t)state) {
              case BT_MESH_GUS_HEALTHY:
-                gus_set_leds(GL|GR);
+                gus_led_engine_set(GUS_LED_LAYER_HEALTH, GL|GR);
             break;
             
             case BT_MESH_GUS_MASKED:
-               gus_set_leds(GL|YR);
+               gus_led_engine_set(GUS_LED_LAYER_HEALTH, GL|YR);
             break;
                           
             case BT_MESH_GUS_VACCINATED:
-                gus_set_leds(BL|BR);
+                gus_led_engine_set(GUS_LED_LAYER_HEALTH, BL|BR);
             break;
 
             case BT_MESH_GUS_VACCINATED_MASKED:
-                gus_set_leds(BL|YR);
+                gus_led_engine_set(GUS_LED_LAYER_HEALTH, BL|YR);
             break;
 
             case BT_MESH_GUS_INFECTED:
-                gus_set_leds(RR|RL);
+                gus_led_engine_set(GUS_LED_LAYER_HEALTH, RR|RL);
             break;
 
             case BT_MESH_GUS_VACCINATED_INFECTED:
-                gus_set_leds(BL|RR);
+                gus_led_engine_set(GUS_LED_LAYER_HEALTH, BL|RR);
             break;
 
             case BT_MESH_GUS_MASKED_INFECTED:
-                gus_set_leds(YL|RR);
+                gus_led_engine_set(GUS_LED_LAYER_HEALTH, YL|RR);
             break;               
                           
             case BT_MESH_GUS_VACCINATED_MASKED_INFECTED:
-                gus_set_leds(YL|YR);
+                gus_led_engine_set(GUS_LED_LAYER_HEALTH, YL|YR);
             break;  
                          
             case BT_MESH_GUS_OFF:
-                gus_set_leds(BLACK);
+                gus_led_engine_set(GUS_LED_LAYER_HEALTH, BLACK);
             break;               
             }
         }
@@ -132,13 +134,13 @@ printk("health: %d state\n", state);
 
 static void attention_on(struct bt_mesh_model *mod)
 {
-	set_blinker(81);
+	gus_led_engine_chase(GUS_LED_LAYER_ATTENTION, GUS_LED_FOREVER,
+			     LED_STEP_MS);
 }
 
 static void attention_off(struct bt_mesh_model *mod)
 {
-	set_blinker(0);
-	dk_set_leds(DK_NO_LEDS_MSK);
+	gus_led_engine_clear(GUS_LED_LAYER_ATTENTION);
 }
 
 static const struct bt_mesh_health_srv_cb health_srv_cb = {
@@ -156,36 +158,60 @@ BT_MESH_HEALTH_PUB_DEFINE(health_pub, 0);
 // ***************************** GUS model setup *******************************
 // ******************************************************************************
 
-static void handle_gus_start(struct bt_mesh_gus *gus)
+// end of a sweep period, our beacon burst has just gone out
+static void sweep_round_end(void)
 {
-    init_distance_data();
+    end_distance_round();
+
+    // pick up the requests the friend queued since the last burst
+    gus_lpn_poll();
 }
 
-static const uint8_t * spare_name(uint16_t addr)
+static void handle_gus_start(struct bt_mesh_gus *gus)
 {
-    const uint8_t * spare_names[] = {
-    "Anja",    "Birgit",    "Casper", "Dag", "Eirik", "Fritjof",
-    "Gunvor",  "Hildur", "Ingolf", "Ingolf",  "Jorg", "Kjerstin",
-    "Lisbet",  "Mikaela", "Niklas", "Oydis",  "Peder", "Ragnhild", };
+    gus_boot_mark(GUS_BOOT_READY);
+    init_distance_data();
 
-#define SPARE_NAME_LEN (sizeof(spare_names)/ sizeof(char *))
-    return spare_names[addr % SPARE_NAME_LEN];
+    if (IS_ENABLED(CONFIG_GUS_SWEEP)) {
+        gus_sweep_start(gus, sweep_round_end);
+    }
+
+    if (IS_ENABLED(CONFIG_GUS_LPN)) {
+        gus_lpn_set(true);
+    }
 }
 
+// no more beacons once the badge has left the network
+static void handle_gus_reset(struct bt_mesh_gus *gus)
+{
+    gus_sweep_stop();
+}
 
 static void handle_gus_signin(struct bt_mesh_gus *gus,
 			       struct bt_mesh_msg_ctx *ctx,
                                uint16_t addr)
 {
-    const uint8_t * name = gus->name;
-    size_t len = strlen(name);
-    if (len < 1) {
-        name = spare_name(addr);
-        len = strlen(name);
-    }
-    printk("handle signin %d %s\n", addr, name);
+    LOG_DBG("handle signin %d", addr);
+
+    (void)bt_mesh_gus_svr_sign_in_reply_cached(gus, ctx);
+}
 
-    (void)bt_mesh_gus_svr_sign_in_reply(gus, ctx, name);
+static void handle_gus_restored(struct bt_mesh_gus *gus)
+{
+    display_health(gus->state);
+    gus_boot_mark(GUS_BOOT_STATE);
+}
+
+static void handle_gus_status(struct bt_mesh_gus *gus,
+                              struct bt_mesh_gus_status *status)
+{
+    // runs from the publication timer, not the RX thread, so it does not
+    // share the report buffer
+    struct gus_report_data contacts[NUM_PROXIMITY_REPORTS];
+
+    status->neighbors = MIN(gus_neighbors_count(), UINT8_MAX);
+    status->contacts = gus_neighbors_top(contacts, NUM_PROXIMITY_REPORTS,
+                                         PROXIMITY_TOO_CLOSE + 1);
 }
 
 static void handle_gus_set_state(struct bt_mesh_gus *gus,
@@ -193,38 +219,144 @@ static void handle_gus_set_state(struct bt_mesh_gus *gus,
 				 enum bt_mesh_gus_state state)
 {
     display_health(state);
+    gus_stream_state(bt_mesh_model_elem(gus->model)->addr, state);
 }
 
 
 
+// start the next proximity round once the report has been sent
+static void report_sent(struct bt_mesh_gus *gus)
+{
+        // Publish the check proximity to all other badges, unless the
+        // badges already beacon on their own schedule
+        if (!gus_sweep_is_running()) {
+            bt_mesh_gus_svr_check_proximity(gus);
+            end_distance_round();
+        }
+}
+
+// report requests are handled one at a time in the mesh RX thread, so the
+// neighbor table is copied into one persistent buffer instead of the stack
+static struct gus_report_data report_buf[NUM_PROXIMITY_REPORTS];
+
 static void handle_report_request(struct bt_mesh_gus *gus,
 				 struct bt_mesh_msg_ctx *ctx)
 {
+    (void)gus_neighbors_top(report_buf, NUM_PROXIMITY_REPORTS,
+                            PROXIMITY_TOO_CLOSE + 1);
+
     for (int i=0; i<NUM_PROXIMITY_REPORTS; i+=2) {
-        printk("rr (%d %d) (%d %d)\n", 
-                                        (int)dist_data[i+0].addr, (int)dist_data[i+0].rssi,
-                                        (int)dist_data[i+1].addr, (int)dist_data[i+1].rssi);
+        LOG_DBG("rr (%d %d) (%d %d)",
+                                        (int)report_buf[i+0].addr, (int)report_buf[i+0].rssi,
+                                        (int)report_buf[i+1].addr, (int)report_buf[i+1].rssi);
     }
         // Send the report back to the teacher
-        bt_mesh_gus_svr_report_reply(gus, ctx, (const uint8_t *) dist_data);
+        bt_mesh_gus_svr_report_reply(gus, ctx, (const uint8_t *) report_buf);
+        report_sent(gus);
+}
+
+static void handle_report_compact_request(struct bt_mesh_gus *gus,
+				 struct bt_mesh_msg_ctx *ctx)
+{
+        size_t count = gus_neighbors_top(report_buf, NUM_PROXIMITY_REPORTS,
+                                         PROXIMITY_TOO_CLOSE + 1);
+
+        bt_mesh_gus_svr_report_compact_reply(gus, ctx, report_buf, count);
+        report_sent(gus);
+}
+
+
+static void handle_exposure_request(struct bt_mesh_gus *gus,
+				 struct bt_mesh_msg_ctx *ctx,
+				 uint16_t after)
+{
+        struct gus_exposure_data exposure[BT_MESH_GUS_EXPOSURE_PAGE];
+        size_t count = gus_neighbors_exposure(after, exposure,
+                                              ARRAY_SIZE(exposure));
+
+        bt_mesh_gus_svr_exposure_reply(gus, ctx,
+                                       MIN(gus_neighbors_exposure_count(),
+                                           UINT8_MAX),
+                                       after, exposure, count);
+}
+
+
+static void handle_log_get(struct bt_mesh_gus *gus,
+			   struct bt_mesh_msg_ctx *ctx,
+			   uint32_t after, uint8_t count)
+{
+        struct gus_contact_record records[BT_MESH_GUS_LOG_PAGE];
+        size_t len = gus_contact_log_read(after, records,
+                                          MIN(count, ARRAY_SIZE(records)));
+
+        bt_mesh_gus_svr_log_reply(gus, ctx, gus_contact_log_last(),
+                                  records, len);
+}
+
+static void handle_stats_get(struct bt_mesh_gus *gus,
+			     struct bt_mesh_msg_ctx *ctx, uint8_t op)
+{
+        struct gus_stats_op stats = { 0 };
+
+        (void)gus_stats_get(op, &stats);
+        bt_mesh_gus_svr_stats_reply(gus, ctx, op, &stats);
+}
+
+static void handle_telemetry_get(struct bt_mesh_gus *gus,
+				 struct bt_mesh_msg_ctx *ctx)
+{
+        struct gus_energy energy;
 
-        // Publish the check proximity to all other badges
-        bt_mesh_gus_svr_check_proximity(gus);
-        init_distance_data();
+        gus_energy_get(&energy);
+        bt_mesh_gus_svr_telemetry_reply(gus, ctx, &energy);
 }
 
 
+// sample the rssi of a status that came straight from another badge
+static void handle_overheard(struct bt_mesh_gus *gus,
+			     struct bt_mesh_msg_ctx *ctx)
+{
+        if (!gus_lpn_established() &&
+            BT_MESH_ADDR_IS_UNICAST(ctx->addr) &&
+            ctx->addr != bt_mesh_model_elem(gus->model)->addr) {
+            add_distance_data(ctx->addr, ctx->recv_rssi, ctx->recv_ttl);
+        }
+}
+
+#ifdef CONFIG_GUS_PASSIVE_PROXIMITY
+static void hb_recv(const struct bt_mesh_hb_sub *sub, uint8_t hops,
+                    uint16_t feat)
+{
+        // heartbeats carry no rssi, a direct one only shows the badge is
+        // still around
+        if (hops == 1) {
+            (void)gus_neighbors_touch(sub->src, k_uptime_get_32());
+        }
+}
+
+BT_MESH_HB_CB_DEFINE(hb_cb) = {
+        .recv = hb_recv,
+};
+#endif
+
 static void handle_check_proximity(struct bt_mesh_gus *gus,
 				 struct bt_mesh_msg_ctx *ctx,
-                                 uint16_t addr)
+                                 uint16_t addr, uint8_t state)
 {
         uint8_t rttl = ctx->recv_ttl;
         int8_t rssi = ctx->recv_rssi;
 
-        printk("prox: addr %d rssi %d, ttl %d\n", addr, rssi, rttl);
+        LOG_DBG("prox: addr %d rssi %d, ttl %d", addr, rssi, rttl);
+
+        // through a friend, the rssi and timing are the friend's
+        if (gus_lpn_established()) {
+            return;
+        }
 
         if (addr != ctx->addr) {
             add_distance_data(ctx->addr, rssi, rttl);
+            gus_spread_heard(ctx->addr, rssi, state);
+            gus_sweep_sync(ctx->addr);
         }
 //        for (int i=0; i<4; ++i)  printk("px: addr %d rssi %d\n", dist_data[i].addr, dist_data[i].rssi);
 }
@@ -233,9 +365,18 @@ static void handle_check_proximity(struct bt_mesh_gus *gus,
 
 static const struct bt_mesh_gus_handlers gus_handlers = {
 	.start = handle_gus_start,
+	.reset = handle_gus_reset,
+	.restored = handle_gus_restored,
+	.status = handle_gus_status,
 	.sign_in = handle_gus_signin,
 	.set_state = handle_gus_set_state,
         .report_request = handle_report_request,
+        .report_compact_request = handle_report_compact_request,
+        .exposure_request = handle_exposure_request,
+        .log_get = handle_log_get,
+        .stats_get = handle_stats_get,
+        .telemetry_get = handle_telemetry_get,
+        .overheard = handle_overheard,
         .check_proximity = handle_check_proximity,
 };
 
@@ -243,13 +384,96 @@ static struct bt_mesh_gus gus = {
 	.handlers = &gus_handlers,
 };
 
+// catch the infection from the infected badges heard during the round
+static void end_spread_round(void)
+{
+    enum bt_mesh_gus_state state = gus_spread_round(gus.state);
+
+    if (state != gus.state) {
+        LOG_INF("spread: infected, state %d", state);
+        bt_mesh_gus_svr_state_set(&gus, state);
+    }
+}
+
+//////////////////////////////
+//  Gus client
+//////////////////////////////
+
+// the simulation brings its own client instance, see bsim/gus_bsim.c
+#if defined(CONFIG_GUS_CLI) && !defined(CONFIG_BOARD_NRF52_BSIM)
+static void cli_sign_in(struct bt_mesh_gus_cli *cli,
+                        struct bt_mesh_msg_ctx *ctx, const char *name)
+{
+    LOG_INF("signed in 0x%04x %s", ctx->addr, log_strdup(name));
+    gus_stream_sign_in(ctx->addr, name);
+}
+
+static void cli_report(struct bt_mesh_gus_cli *cli,
+                       struct bt_mesh_msg_ctx *ctx,
+                       const struct gus_report_data *report, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        LOG_INF("report 0x%04x: 0x%04x %d", ctx->addr, report[i].addr,
+                report[i].rssi);
+    }
+    gus_stream_report(ctx->addr, report, count);
+}
+
+static void cli_status(struct bt_mesh_gus_cli *cli,
+                       struct bt_mesh_msg_ctx *ctx,
+                       const struct bt_mesh_gus_status *status)
+{
+    gus_stream_status(ctx->addr, status);
+}
+
+static void cli_timeout(struct bt_mesh_gus_cli *cli, uint16_t addr)
+{
+    LOG_WRN("no reply from 0x%04x", addr);
+    gus_stream_timeout(addr);
+}
+
+static void cli_done(struct bt_mesh_gus_cli *cli)
+{
+    LOG_INF("collection done");
+}
+
+static const struct bt_mesh_gus_cli_handlers gus_cli_handlers = {
+    .sign_in = cli_sign_in,
+    .report = cli_report,
+    .status = cli_status,
+    .timeout = cli_timeout,
+    .done = cli_done,
+};
+
+static struct bt_mesh_gus_cli gus_cli = {
+    .handlers = &gus_cli_handlers,
+};
+
+struct bt_mesh_gus_cli *gus_model_handler_cli(void)
+{
+    return &gus_cli;
+}
+
+#define GUS_CLI_MODELS , BT_MESH_MODEL_GUS_CLI(&gus_cli)
+#else
+struct bt_mesh_gus_cli *gus_model_handler_cli(void)
+{
+    return NULL;
+}
+
+#define GUS_CLI_MODELS
+#endif
+
 static struct bt_mesh_elem elements[] = {
 	BT_MESH_ELEM(
 		1,
 		BT_MESH_MODEL_LIST(
 			BT_MESH_MODEL_CFG_SRV,
+			GUS_BSIM_SIG_MODELS
 			BT_MESH_MODEL_HEALTH_SRV(&health_srv, &health_pub)),
-		BT_MESH_MODEL_LIST(BT_MESH_MODEL_GUS_SVR(&gus))),
+		BT_MESH_MODEL_LIST(BT_MESH_MODEL_GUS_SVR(&gus)
+				   GUS_CLI_MODELS
+				   GUS_BSIM_VND_MODELS)),
 };
 
 static const struct bt_mesh_comp comp = {
@@ -266,10 +490,13 @@ static void button_handler_cb(uint32_t pressed, uint32_t changed)
 
     if ((pressed & changed & BIT(1))) {
         bt_mesh_reset();
-        dk_set_leds(1);
+        gus_led_engine_set(GUS_LED_LAYER_HEALTH, DK_LED1_MSK);
+    }
+    else if (IS_ENABLED(CONFIG_GUS_LPN) && (pressed & changed & BIT(0))) {
+        gus_lpn_toggle();
     }
     else {
-        dk_set_leds(2);
+        gus_led_engine_set(GUS_LED_LAYER_HEALTH, DK_LED2_MSK);
     }
 }
 
@@ -279,7 +506,23 @@ const struct bt_mesh_comp *gus_model_handler_init(void)
 		.cb = button_handler_cb,
 	};
 
-	dk_button_handler_add(&button_handler);
+	if (IS_ENABLED(CONFIG_DK_LIBRARY)) {
+		dk_button_handler_add(&button_handler);
+	}
+
+	if (IS_ENABLED(CONFIG_GUS_CONTACT_LOG)) {
+		int err = gus_contact_log_init();
+
+		if (err) {
+			LOG_ERR("Contact log init failed (err %d)", err);
+		}
+	}
 
 	return &comp;
 }
+
+void gus_model_handler_restore_early(void)
+{
+	// the Gus server is the first vendor model of the first element
+	(void)bt_mesh_gus_svr_restore_early(&gus, 0, 0);
+}
@@ -19,8 +19,17 @@ extern "C" {
 #endif
 
 const struct bt_mesh_comp *gus_model_handler_init(void);
-int get_blinker(void);
-int dec_blinker(void);
+
+/** @brief Show the stored health state before the mesh is up. */
+void gus_model_handler_restore_early(void);
+
+struct bt_mesh_gus_cli;
+
+/** @brief Get the Gus client model of the badge.
+ *
+ *  @return The client, or NULL without CONFIG_GUS_CLI.
+ */
+struct bt_mesh_gus_cli *gus_model_handler_cli(void);
 
 #ifdef __cplusplus
 }
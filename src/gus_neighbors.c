@@ -0,0 +1,510 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <errno.h>
+#include <string.h>
+#include "gus_neighbors.h"
+
+#define TABLE_SIZE CONFIG_GUS_NEIGHBOR_TABLE_SIZE
+#define EXPOSURE_SIZE CONFIG_GUS_EXPOSURE_TABLE_SIZE
+#define TOP_SIZE   NUM_PROXIMITY_REPORTS
+#define HASH_SIZE  256                  // power of two, twice the table size
+#define HASH_MASK  (HASH_SIZE - 1)
+#define NO_ENTRY   0xFF
+
+// rssi filter, all values are in 1/16 dB (Q4)
+#define Q                4
+#define ALPHA_SHIFT      2              // EWMA weight of a new sample, 1/4
+#define MAX_STEP         (12 << Q)      // largest deviation a sample can add
+#define VAR_INIT         (36 << Q)      // 6 dB standard deviation
+#define VAR_STABLE       (9 << Q)       // 3 dB standard deviation
+#define VAR_NOISY        (64 << Q)      // 8 dB standard deviation
+#define SAMPLES_STABLE   4
+
+static const int8_t band_rssi[BT_MESH_GUS_EXPOSURE_BANDS] = {
+	CONFIG_GUS_EXPOSURE_RSSI_NEAR,
+	CONFIG_GUS_EXPOSURE_RSSI_MID,
+	CONFIG_GUS_EXPOSURE_RSSI_FAR,
+};
+
+BUILD_ASSERT(TABLE_SIZE * 2 <= HASH_SIZE, "The hash index is too small");
+BUILD_ASSERT(TABLE_SIZE < NO_ENTRY, "Entry indexes must fit in a byte");
+BUILD_ASSERT(EXPOSURE_SIZE <= UINT8_MAX, "The exposure count must fit in a byte");
+
+static struct {
+	uint16_t addr[TABLE_SIZE];
+	int16_t rssi[TABLE_SIZE];       // smoothed rssi
+	uint16_t var[TABLE_SIZE];       // smoothed rssi variance, 1/16 dB^2
+	uint8_t samples[TABLE_SIZE];    // samples since added, saturated
+	uint8_t age[TABLE_SIZE];        // rounds since the last sample
+	uint32_t last_seen[TABLE_SIZE]; // time of the last sample, ms
+	uint8_t heap_pos[TABLE_SIZE];   // position in top, or NO_ENTRY
+	uint8_t index[HASH_SIZE];       // entry of each hash slot, or NO_ENTRY
+	uint8_t top[TOP_SIZE];          // min-heap of entries on rssi
+	uint8_t top_len;
+	uint8_t count;
+} tbl;
+
+// contact time, kept after the neighbor left the table, sorted by address
+static struct {
+	uint16_t addr[EXPOSURE_SIZE];
+	uint32_t contact[BT_MESH_GUS_EXPOSURE_BANDS][EXPOSURE_SIZE]; // ms
+	uint8_t count;
+} exp;
+
+/////////////////////
+// Static functions
+/////////////////////
+
+static uint32_t hash(uint16_t addr)
+{
+	// Fibonacci hashing, unicast addresses are mostly sequential
+	return ((addr * 40503U) >> 8) & HASH_MASK;
+}
+
+// find the hash slot of an address, or the empty slot where it belongs
+static uint32_t find_slot(uint16_t addr)
+{
+	uint32_t slot = hash(addr);
+
+	while (tbl.index[slot] != NO_ENTRY &&
+	       tbl.addr[tbl.index[slot]] != addr) {
+		slot = (slot + 1) & HASH_MASK;
+	}
+
+	return slot;
+}
+
+// empty a hash slot, shifting back the entries probed past it
+static void clear_slot(uint32_t slot)
+{
+	uint32_t next = slot;
+
+	for (;;) {
+		next = (next + 1) & HASH_MASK;
+		if (tbl.index[next] == NO_ENTRY) {
+			break;
+		}
+
+		uint32_t home = hash(tbl.addr[tbl.index[next]]);
+
+		// move the entry unless its home lies in (slot, next]
+		if (((next - home) & HASH_MASK) >= ((next - slot) & HASH_MASK)) {
+			tbl.index[slot] = tbl.index[next];
+			slot = next;
+		}
+	}
+	tbl.index[slot] = NO_ENTRY;
+}
+
+static void heap_set(uint8_t pos, uint8_t entry)
+{
+	tbl.top[pos] = entry;
+	tbl.heap_pos[entry] = pos;
+}
+
+static void sift_up(uint8_t pos)
+{
+	uint8_t entry = tbl.top[pos];
+
+	while (pos > 0) {
+		uint8_t parent = (pos - 1) / 2;
+
+		if (tbl.rssi[tbl.top[parent]] <= tbl.rssi[entry]) {
+			break;
+		}
+		heap_set(pos, tbl.top[parent]);
+		pos = parent;
+	}
+	heap_set(pos, entry);
+}
+
+static void sift_down(uint8_t pos)
+{
+	uint8_t entry = tbl.top[pos];
+
+	for (;;) {
+		uint8_t child = 2 * pos + 1;
+
+		if (child >= tbl.top_len) {
+			break;
+		}
+		if (child + 1 < tbl.top_len &&
+		    tbl.rssi[tbl.top[child + 1]] < tbl.rssi[tbl.top[child]]) {
+			child++;
+		}
+		if (tbl.rssi[entry] <= tbl.rssi[tbl.top[child]]) {
+			break;
+		}
+		heap_set(pos, tbl.top[child]);
+		pos = child;
+	}
+	heap_set(pos, entry);
+}
+
+// give an entry that is not in the top a chance to get in
+static void offer_top(uint8_t entry)
+{
+	if (tbl.top_len < TOP_SIZE) {
+		heap_set(tbl.top_len++, entry);
+		sift_up(tbl.heap_pos[entry]);
+	} else if (tbl.rssi[entry] > tbl.rssi[tbl.top[0]]) {
+		tbl.heap_pos[tbl.top[0]] = NO_ENTRY;
+		heap_set(0, entry);
+		sift_down(0);
+	}
+}
+
+// offer every entry outside the top again, after a member of the top left
+// or weakened below a neighbor outside
+static void refill_top(void)
+{
+	for (uint8_t i = 0; i < tbl.count; ++i) {
+		if (tbl.heap_pos[i] == NO_ENTRY) {
+			offer_top(i);
+		}
+	}
+}
+
+static void remove_top(uint8_t entry)
+{
+	uint8_t pos = tbl.heap_pos[entry];
+
+	tbl.heap_pos[entry] = NO_ENTRY;
+	if (pos != --tbl.top_len) {
+		uint8_t last = tbl.top[tbl.top_len];
+
+		heap_set(pos, last);
+		sift_up(pos);
+		sift_down(tbl.heap_pos[last]);
+	}
+}
+
+// move an entry to another index, keeping the index and heap in sync
+static void move_entry(uint8_t from, uint8_t to)
+{
+	tbl.addr[to] = tbl.addr[from];
+	tbl.rssi[to] = tbl.rssi[from];
+	tbl.var[to] = tbl.var[from];
+	tbl.samples[to] = tbl.samples[from];
+	tbl.age[to] = tbl.age[from];
+	tbl.last_seen[to] = tbl.last_seen[from];
+	tbl.heap_pos[to] = tbl.heap_pos[from];
+
+	tbl.index[find_slot(tbl.addr[to])] = to;
+	if (tbl.heap_pos[to] != NO_ENTRY) {
+		tbl.top[tbl.heap_pos[to]] = to;
+	}
+}
+
+static void remove_entry(uint8_t entry)
+{
+	if (tbl.heap_pos[entry] != NO_ENTRY) {
+		remove_top(entry);
+	}
+	clear_slot(find_slot(tbl.addr[entry]));
+
+	if (entry != --tbl.count) {
+		move_entry(tbl.count, entry);
+	}
+}
+
+// fold a sample into the smoothed rssi and variance of an entry
+static void filter_sample(uint8_t entry, int8_t rssi)
+{
+	int32_t dev = ((int32_t)rssi << Q) - tbl.rssi[entry];
+	int32_t var = tbl.var[entry];
+
+	// a single spike can only pull the estimate so far
+	dev = CLAMP(dev, -MAX_STEP, MAX_STEP);
+
+	tbl.rssi[entry] += dev >> ALPHA_SHIFT;
+	var += (((dev * dev) >> Q) - var) >> ALPHA_SHIFT;
+	tbl.var[entry] = MIN(var, UINT16_MAX);
+
+	if (tbl.samples[entry] < UINT8_MAX) {
+		tbl.samples[entry]++;
+	}
+	tbl.age[entry] = 0;
+}
+
+// index of the first exposure entry with an address above addr
+static uint8_t exposure_after(uint16_t addr)
+{
+	uint8_t low = 0;
+	uint8_t high = exp.count;
+
+	while (low < high) {
+		uint8_t mid = (low + high) / 2;
+
+		if (exp.addr[mid] <= addr) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+static int exposure_find(uint16_t addr)
+{
+	uint8_t pos = exposure_after(addr);
+
+	return (pos > 0 && exp.addr[pos - 1] == addr) ? pos - 1 : -ENOENT;
+}
+
+static void exposure_move(uint8_t from, uint8_t to)
+{
+	exp.addr[to] = exp.addr[from];
+	for (int band = 0; band < BT_MESH_GUS_EXPOSURE_BANDS; ++band) {
+		exp.contact[band][to] = exp.contact[band][from];
+	}
+}
+
+// the exposure entry of an address, added if needed; a full table gives
+// up the neighbor with the least contact time
+static uint8_t exposure_get(uint16_t addr)
+{
+	int found = exposure_find(addr);
+	uint8_t pos;
+
+	if (found >= 0) {
+		return found;
+	}
+
+	if (exp.count == EXPOSURE_SIZE) {
+		uint8_t least = 0;
+
+		for (uint8_t i = 1; i < exp.count; ++i) {
+			if (exp.contact[BT_MESH_GUS_EXPOSURE_BANDS - 1][i] <
+			    exp.contact[BT_MESH_GUS_EXPOSURE_BANDS - 1][least]) {
+				least = i;
+			}
+		}
+		for (uint8_t i = least; i + 1 < exp.count; ++i) {
+			exposure_move(i + 1, i);
+		}
+		exp.count--;
+	}
+
+	pos = exposure_after(addr);
+	for (uint8_t i = exp.count; i > pos; --i) {
+		exposure_move(i - 1, i);
+	}
+	exp.count++;
+
+	exp.addr[pos] = addr;
+	for (int band = 0; band < BT_MESH_GUS_EXPOSURE_BANDS; ++band) {
+		exp.contact[band][pos] = 0;
+	}
+
+	return pos;
+}
+
+static void exposure_copy(uint8_t pos, struct gus_exposure_data *exposure)
+{
+	exposure->addr = exp.addr[pos];
+	for (int band = 0; band < BT_MESH_GUS_EXPOSURE_BANDS; ++band) {
+		exposure->seconds[band] = MIN(exp.contact[band][pos] / 1000,
+					      UINT16_MAX);
+	}
+}
+
+// add the time since the last sample to the bands the neighbor is in
+static void integrate_contact(uint8_t entry, uint32_t now)
+{
+	uint32_t elapsed = now - tbl.last_seen[entry];
+	uint8_t pos;
+
+	tbl.last_seen[entry] = now;
+	if (elapsed > CONFIG_GUS_EXPOSURE_MAX_GAP_MS || elapsed == 0 ||
+	    tbl.rssi[entry] < (band_rssi[BT_MESH_GUS_EXPOSURE_BANDS - 1] << Q)) {
+		return;
+	}
+
+	pos = exposure_get(tbl.addr[entry]);
+	for (int band = 0; band < BT_MESH_GUS_EXPOSURE_BANDS; ++band) {
+		if (tbl.rssi[entry] >= (band_rssi[band] << Q) &&
+		    exp.contact[band][pos] <= UINT32_MAX - elapsed) {
+			exp.contact[band][pos] += elapsed;
+		}
+	}
+}
+
+static uint8_t confidence(uint8_t entry)
+{
+	uint8_t conf;
+
+	if (tbl.samples[entry] < 2 || tbl.var[entry] > VAR_NOISY) {
+		conf = BT_MESH_GUS_CONFIDENCE_LOW;
+	} else if (tbl.samples[entry] < SAMPLES_STABLE ||
+		   tbl.var[entry] > VAR_STABLE) {
+		conf = BT_MESH_GUS_CONFIDENCE_MEDIUM;
+	} else {
+		conf = BT_MESH_GUS_CONFIDENCE_HIGH;
+	}
+
+	// not heard in the last round
+	if (tbl.age[entry] > 0 && conf > BT_MESH_GUS_CONFIDENCE_NONE) {
+		conf--;
+	}
+
+	return conf;
+}
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+void gus_neighbors_reset(void)
+{
+	memset(tbl.index, NO_ENTRY, sizeof(tbl.index));
+	tbl.top_len = 0;
+	tbl.count = 0;
+	exp.count = 0;
+}
+
+void gus_neighbors_new_round(void)
+{
+	uint8_t i = 0;
+
+	while (i < tbl.count) {
+		if (tbl.age[i] >= CONFIG_GUS_NEIGHBOR_MAX_AGE) {
+			// the last entry moves to i, check it next
+			remove_entry(i);
+			continue;
+		}
+		tbl.age[i++]++;
+	}
+
+	// neighbors that aged out of the top leave room for the others
+	if (tbl.top_len < MIN(tbl.count, TOP_SIZE)) {
+		refill_top();
+	}
+}
+
+int gus_neighbors_add(uint16_t addr, int8_t rssi, uint32_t now)
+{
+	uint32_t slot = find_slot(addr);
+	uint8_t entry = tbl.index[slot];
+
+	if (entry == NO_ENTRY) {
+		if (tbl.count == TABLE_SIZE) {
+			return -ENOMEM;
+		}
+
+		entry = tbl.count++;
+		tbl.index[slot] = entry;
+		tbl.addr[entry] = addr;
+		tbl.rssi[entry] = (int16_t)rssi << Q;
+		tbl.var[entry] = VAR_INIT;
+		tbl.samples[entry] = 1;
+		tbl.age[entry] = 0;
+		tbl.last_seen[entry] = now;
+		tbl.heap_pos[entry] = NO_ENTRY;
+		offer_top(entry);
+		return 0;
+	}
+
+	int16_t old = tbl.rssi[entry];
+
+	filter_sample(entry, rssi);
+	integrate_contact(entry, now);
+
+	if (tbl.heap_pos[entry] == NO_ENTRY) {
+		offer_top(entry);
+	} else if (tbl.rssi[entry] > old) {
+		// stronger in a min-heap moves toward the leaves
+		sift_down(tbl.heap_pos[entry]);
+	} else {
+		sift_up(tbl.heap_pos[entry]);
+
+		// only the weakest of the top can fall below a neighbor outside
+		if (tbl.heap_pos[entry] == 0 && tbl.count > tbl.top_len) {
+			refill_top();
+		}
+	}
+
+	return 0;
+}
+
+int gus_neighbors_touch(uint16_t addr, uint32_t now)
+{
+	uint8_t entry = tbl.index[find_slot(addr)];
+
+	if (entry == NO_ENTRY) {
+		return -ENOENT;
+	}
+
+	integrate_contact(entry, now);
+	tbl.age[entry] = 0;
+
+	return 0;
+}
+
+size_t gus_neighbors_count(void)
+{
+	return tbl.count;
+}
+
+size_t gus_neighbors_top(struct gus_report_data *report, size_t max,
+			 int8_t min_rssi)
+{
+	size_t len = 0;
+
+	for (uint8_t i = 0; i < tbl.top_len && len < max; ++i) {
+		uint8_t entry = tbl.top[i];
+		int8_t rssi = (tbl.rssi[entry] + (1 << (Q - 1))) >> Q;
+
+		if (rssi < min_rssi) {
+			continue;
+		}
+
+		report[len].addr = tbl.addr[entry];
+		report[len].rssi = rssi;
+		report[len].confidence = confidence(entry);
+		len++;
+	}
+
+	for (size_t i = len; i < max; ++i) {
+		report[i].addr = 0;
+		report[i].rssi = -127;
+		report[i].confidence = BT_MESH_GUS_CONFIDENCE_NONE;
+	}
+
+	return len;
+}
+
+size_t gus_neighbors_exposure_count(void)
+{
+	return exp.count;
+}
+
+size_t gus_neighbors_exposure(uint16_t after,
+			      struct gus_exposure_data *exposure, size_t max)
+{
+	size_t len = 0;
+
+	for (uint8_t i = exposure_after(after); i < exp.count && len < max;
+	     ++i) {
+		exposure_copy(i, &exposure[len++]);
+	}
+
+	return len;
+}
+
+int gus_neighbors_find(uint16_t addr, struct gus_exposure_data *exposure)
+{
+	int pos = exposure_find(addr);
+
+	if (pos < 0) {
+		return pos;
+	}
+
+	exposure_copy(pos, exposure);
+	return 0;
+}
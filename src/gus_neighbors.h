@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus neighbor table
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// Neighbor table - collects the proximity samples of a round.
+//
+// The table holds up to CONFIG_GUS_NEIGHBOR_TABLE_SIZE neighbors in a
+// struct-of-arrays layout.  Addresses are found through an open addressing
+// hash index, and the NUM_PROXIMITY_REPORTS strongest neighbors are kept in
+// a min-heap, so adding a sample costs the same no matter how many
+// neighbors have been heard, and the report is read straight out of the
+// heap.
+//
+// Neighbors are kept across rounds with a smoothed rssi (fixed point EWMA)
+// so reports do not depend on a single lucky packet.  The heap always holds
+// the strongest neighbors in the table: when a member of the top ages out,
+// or weakens to become the weakest of the top, the neighbors outside are
+// offered to the heap again.
+//
+// Each neighbor also accumulates its contact time: the time between two
+// samples is added to every rssi band (near, mid, far) the smoothed rssi is
+// in, so the client can read exposure minutes instead of polling every
+// round.  The contact times live in their own table, sorted by address,
+// and stay there after the neighbor aged out of the neighbor table, so a
+// contact that ended is still read minutes later.  When that table is
+// full, the neighbor with the least contact time makes room.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GUS_NEIGHBORS_H__
+#define GUS_NEIGHBORS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "gus_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Remove all neighbors from the table. */
+void gus_neighbors_reset(void);
+
+/** @brief Start a new proximity round.
+ *
+ *  Ages all neighbors by one round and drops the neighbors that have not
+ *  been heard for CONFIG_GUS_NEIGHBOR_MAX_AGE rounds.
+ */
+void gus_neighbors_new_round(void);
+
+/** @brief Add a proximity sample.
+ *
+ *  The sample is folded into the smoothed rssi and rssi variance of the
+ *  neighbor, which carry over from round to round.  A single sample can
+ *  move the smoothed rssi by a limited step only, so one strong packet
+ *  does not make a far neighbor look close.
+ *
+ *  @param addr Unicast address of the neighbor.
+ *  @param rssi Received signal strength of the sample.
+ *  @param now  Uptime of the sample in milliseconds.
+ *
+ *  @retval 0       The sample was added.
+ *  @retval -ENOMEM The table is full and @p addr is not in it.
+ */
+int gus_neighbors_add(uint16_t addr, int8_t rssi, uint32_t now);
+
+/** @brief Mark a known neighbor as heard without an rssi sample.
+ *
+ *  Keeps the neighbor from aging out and adds the time since its last
+ *  sample to its contact time, at its current smoothed rssi.
+ *
+ *  @param addr Unicast address of the neighbor.
+ *  @param now  Uptime in milliseconds.
+ *
+ *  @retval 0       The neighbor was found.
+ *  @retval -ENOENT The neighbor is not in the table.
+ */
+int gus_neighbors_touch(uint16_t addr, uint32_t now);
+
+/** @brief Number of neighbors in the table. */
+size_t gus_neighbors_count(void);
+
+/** @brief Get the strongest neighbors.
+ *
+ *  The entries are copied in heap order, not sorted by rssi, with the
+ *  smoothed rssi and a confidence level derived from the sample count,
+ *  the rssi variance and the age of the neighbor.  Entries past the
+ *  returned count are cleared to address 0.
+ *
+ *  @param report   Destination of the entries.
+ *  @param max      Number of entries in @p report.
+ *  @param min_rssi Weakest smoothed rssi that is reported.
+ *
+ *  @return Number of valid entries copied to @p report.
+ */
+size_t gus_neighbors_top(struct gus_report_data *report, size_t max,
+			 int8_t min_rssi);
+
+/** @brief Number of neighbors with contact time. */
+size_t gus_neighbors_exposure_count(void);
+
+/** @brief Get the contact time of the neighbors, in address order.
+ *
+ *  Pages stay stable while neighbors come and go: the next page starts
+ *  after the address of the last entry of the previous one.
+ *
+ *  @param after    Copy the neighbors with an address above this one, 0
+ *                  for the first page.
+ *  @param exposure Destination of the contact times.
+ *  @param max      Number of entries in @p exposure.
+ *
+ *  @return Number of entries copied to @p exposure.
+ */
+size_t gus_neighbors_exposure(uint16_t after,
+			      struct gus_exposure_data *exposure, size_t max);
+
+/** @brief Get the contact time of one neighbor.
+ *
+ *  @param addr     Unicast address of the neighbor.
+ *  @param exposure Destination of the contact time.
+ *
+ *  @retval 0       The neighbor was found.
+ *  @retval -ENOENT The neighbor has no contact time.
+ */
+int gus_neighbors_find(uint16_t addr, struct gus_exposure_data *exposure);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_NEIGHBORS_H__ */
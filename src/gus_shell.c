@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/////////////////////////////////////////////////////////////////////////
+// "gus" shell commands on the UART console.
+// Zephyr has no way to add subcommands to a command from other files, so
+// all badge commands are collected here.
+/////////////////////////////////////////////////////////////////////////
+
+#ifdef CONFIG_SHELL
+
+#include <zephyr.h>
+#include <stdlib.h>
+#include <string.h>
+#include <shell/shell.h>
+#include "gus_stats.h"
+#include "gus_energy.h"
+#include "gus_boot.h"
+#include "gus_log.h"
+#include "gus_stream.h"
+#include "gus_tx.h"
+#include "gus_contact_log.h"
+#include "tx_power.h"
+#include "gus_model_handler.h"
+#ifdef CONFIG_GUS_CLI
+#include "gus_cli.h"
+#endif
+
+static int cmd_stats(const struct shell *shell, size_t argc, char **argv)
+{
+	shell_print(shell, "op      rx      tx  tx_err  latency <8us .. >=512us");
+
+	for (uint8_t num = 0; num < GUS_STATS_OPS; ++num) {
+		struct gus_stats_op op;
+
+		if (gus_stats_get(num, &op) || (!op.rx && !op.tx && !op.tx_err)) {
+			continue;
+		}
+
+		shell_print(shell,
+			    "0x%02x %7u %7u %7u  %u %u %u %u %u %u %u %u",
+			    num, op.rx, op.tx, op.tx_err, op.latency[0],
+			    op.latency[1], op.latency[2], op.latency[3],
+			    op.latency[4], op.latency[5], op.latency[6],
+			    op.latency[7]);
+	}
+
+	return 0;
+}
+
+static int cmd_stats_reset(const struct shell *shell, size_t argc,
+			   char **argv)
+{
+	gus_stats_reset();
+	return 0;
+}
+
+static int cmd_energy(const struct shell *shell, size_t argc, char **argv)
+{
+	struct gus_energy energy;
+
+	gus_energy_get(&energy);
+	shell_print(shell, "uptime %u s", energy.uptime_s);
+	shell_print(shell, "tx     %u events, %u ms", energy.tx_count,
+		    energy.tx_ms);
+	shell_print(shell, "scan   %u s", energy.scan_s);
+	shell_print(shell, "leds   %u ms", energy.led_ms);
+	shell_print(shell, "charge %u uAh", energy.charge_uah);
+
+	return 0;
+}
+
+static int cmd_boot(const struct shell *shell, size_t argc, char **argv)
+{
+	for (int i = 0; i < GUS_BOOT_PHASES; ++i) {
+		uint64_t us = gus_boot_time_us(i);
+
+		shell_print(shell, "%-6s %u.%03u ms", gus_boot_name(i),
+			    (uint32_t)(us / 1000), (uint32_t)(us % 1000));
+	}
+
+	return 0;
+}
+
+static int cmd_log(const struct shell *shell, size_t argc, char **argv)
+{
+	shell_print(shell, "dropped %u", gus_log_dropped());
+	shell_print(shell, "stream dropped %u", gus_stream_dropped());
+	shell_print(shell, "contact log dropped %u", gus_contact_log_dropped());
+
+	return 0;
+}
+
+static int cmd_tx(const struct shell *shell, size_t argc, char **argv)
+{
+	struct gus_tx_stats tx;
+
+	gus_tx_stats_get(&tx);
+	shell_print(shell, "queued %u sent %u retries %u dropped %u err %u",
+		    tx.queued, tx.sent, tx.retries, tx.dropped, tx.send_err);
+	shell_print(shell, "depth %u max %u", tx.depth, tx.max_depth);
+
+	return 0;
+}
+
+static int cmd_txcal(const struct shell *shell, size_t argc, char **argv)
+{
+	if (argc > 1) {
+		char *end;
+		long offset = strtol(argv[1], &end, 0);
+
+		if (*end || offset < -TX_POWER_CALIBRATION_MAX ||
+		    offset > TX_POWER_CALIBRATION_MAX) {
+			shell_error(shell, "offset must be -%d..%d dB",
+				    TX_POWER_CALIBRATION_MAX,
+				    TX_POWER_CALIBRATION_MAX);
+			return -EINVAL;
+		}
+
+		int err = tx_power_calibration_set(offset);
+
+		if (err) {
+			shell_error(shell, "storing failed (err %d)", err);
+			return err;
+		}
+	}
+
+	shell_print(shell, "beacon tx power calibration %d dB",
+		    tx_power_calibration_get());
+
+	return 0;
+}
+
+#ifdef CONFIG_GUS_CLI
+// the client reads the addresses until its done callback
+static uint16_t collect_addrs[BT_MESH_GUS_SET_STATES_MAX];
+
+static bool parse_u16(const char *arg, uint16_t *out)
+{
+	char *end;
+	unsigned long val = strtoul(arg, &end, 0);
+
+	if (*end || val > UINT16_MAX) {
+		return false;
+	}
+
+	*out = val;
+	return true;
+}
+
+// context of the client's first application key, the subnet follows from
+// the key
+static int cli_ctx(const struct shell *shell, struct bt_mesh_gus_cli *cli,
+		   struct bt_mesh_msg_ctx *ctx)
+{
+	if (!cli->model || cli->model->keys[0] == BT_MESH_KEY_UNUSED) {
+		shell_error(shell, "bind an application key to the client");
+		return -EADDRNOTAVAIL;
+	}
+
+	*ctx = (struct bt_mesh_msg_ctx) {
+		.app_idx = cli->model->keys[0],
+		.send_ttl = BT_MESH_TTL_DEFAULT,
+	};
+
+	return 0;
+}
+
+static int cmd_collect(const struct shell *shell, size_t argc, char **argv)
+{
+	struct bt_mesh_gus_cli *cli = gus_model_handler_cli();
+	struct bt_mesh_msg_ctx ctx;
+	uint16_t first;
+	uint16_t count;
+	uint32_t op;
+	int err;
+
+	if (!strcmp(argv[1], "cancel")) {
+		bt_mesh_gus_cli_cancel(cli);
+		return 0;
+	}
+
+	if (argc != 4) {
+		shell_error(shell, "give the first address and the count");
+		return -EINVAL;
+	}
+
+	if (!strcmp(argv[1], "signin")) {
+		op = BT_MESH_GUS_OP_SIGN_IN;
+	} else if (!strcmp(argv[1], "report")) {
+		op = BT_MESH_GUS_OP_REPORT;
+	} else if (!strcmp(argv[1], "compact")) {
+		op = BT_MESH_GUS_OP_REPORT_COMPACT;
+	} else {
+		shell_error(shell, "request must be signin, report or compact");
+		return -EINVAL;
+	}
+
+	if (!parse_u16(argv[2], &first) || !parse_u16(argv[3], &count) ||
+	    count == 0 || count > ARRAY_SIZE(collect_addrs) ||
+	    !BT_MESH_ADDR_IS_UNICAST(first) ||
+	    !BT_MESH_ADDR_IS_UNICAST(first + count - 1)) {
+		shell_error(shell, "up to %d unicast addresses",
+			    BT_MESH_GUS_SET_STATES_MAX);
+		return -EINVAL;
+	}
+
+	if (bt_mesh_gus_cli_busy(cli)) {
+		shell_error(shell, "a collection is running");
+		return -EBUSY;
+	}
+
+	err = cli_ctx(shell, cli, &ctx);
+	if (err) {
+		return err;
+	}
+
+	for (uint16_t i = 0; i < count; ++i) {
+		collect_addrs[i] = first + i;
+	}
+
+	err = bt_mesh_gus_cli_collect(cli, &ctx, op, collect_addrs, count);
+	if (err) {
+		shell_error(shell, "collect failed (err %d)", err);
+	}
+
+	return err;
+}
+
+static int cmd_states(const struct shell *shell, size_t argc, char **argv)
+{
+	struct bt_mesh_gus_cli *cli = gus_model_handler_cli();
+	uint8_t states[BT_MESH_GUS_SET_STATES_MAX];
+	struct bt_mesh_msg_ctx ctx;
+	size_t count = strlen(argv[3]);
+	uint16_t dst;
+	uint16_t base;
+	int err;
+
+	if (!parse_u16(argv[1], &dst) || !parse_u16(argv[2], &base) ||
+	    dst == BT_MESH_ADDR_UNASSIGNED || !BT_MESH_ADDR_IS_UNICAST(base)) {
+		shell_error(shell, "bad destination or base address");
+		return -EINVAL;
+	}
+
+	if (count == 0 || count > ARRAY_SIZE(states)) {
+		shell_error(shell, "up to %d states",
+			    BT_MESH_GUS_SET_STATES_MAX);
+		return -EINVAL;
+	}
+
+	// one hex digit per badge, f leaves the badge alone
+	for (size_t i = 0; i < count; ++i) {
+		char digit[2] = { argv[3][i] };
+		char *end;
+
+		states[i] = strtoul(digit, &end, 16);
+		if (*end || (states[i] > BT_MESH_GUS_OFF &&
+			     states[i] != BT_MESH_GUS_STATE_UNCHANGED)) {
+			shell_error(shell, "bad state '%c'", argv[3][i]);
+			return -EINVAL;
+		}
+	}
+
+	err = cli_ctx(shell, cli, &ctx);
+	if (err) {
+		return err;
+	}
+
+	ctx.addr = dst;
+	err = bt_mesh_gus_cli_set_states(cli, &ctx, base, states, count);
+	if (err) {
+		shell_error(shell, "set states failed (err %d)", err);
+	}
+
+	return err;
+}
+#endif /* CONFIG_GUS_CLI */
+
+SHELL_STATIC_SUBCMD_SET_CREATE(gus_stats_cmds,
+	SHELL_CMD(reset, NULL, "Clear the message statistics",
+		  cmd_stats_reset),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(gus_cmds,
+	SHELL_CMD(stats, &gus_stats_cmds, "Show the message statistics",
+		  cmd_stats),
+	SHELL_CMD(energy, NULL, "Show the energy counters", cmd_energy),
+	SHELL_CMD(boot, NULL, "Show the boot phase times", cmd_boot),
+	SHELL_CMD(tx, NULL, "Show the outbound queue counters", cmd_tx),
+	SHELL_CMD(log, NULL, "Show the dropped log messages and stream records", cmd_log),
+	SHELL_CMD_ARG(txcal, NULL,
+		      "Show or set the beacon tx power calibration [dB]",
+		      cmd_txcal, 1, 1),
+#ifdef CONFIG_GUS_CLI
+	SHELL_CMD_ARG(collect, NULL,
+		      "Collect from badges: <signin|report|compact> <first> "
+		      "<count>, or cancel", cmd_collect, 2, 2),
+	SHELL_CMD_ARG(states, NULL,
+		      "Set badge states: <dst> <base> <hex digit per badge, "
+		      "f unchanged>", cmd_states, 4, 0),
+#endif
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(gus, &gus_cmds, "Gus badge commands", NULL);
+#endif /* CONFIG_SHELL */
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <random/rand32.h>
+#include "gus_spread.h"
+
+#ifdef CONFIG_GUS_SPREAD
+
+#define PERMILLE 1000
+
+struct source {
+	uint16_t addr;
+	int8_t rssi;           // strongest of the round
+	bool masked;
+};
+
+static struct source sources[CONFIG_GUS_SPREAD_SOURCES];
+static size_t source_count;
+static struct k_spinlock lock;
+
+static bool is_masked(uint8_t state)
+{
+	switch (state) {
+	case BT_MESH_GUS_MASKED:
+	case BT_MESH_GUS_MASKED_INFECTED:
+	case BT_MESH_GUS_VACCINATED_MASKED:
+	case BT_MESH_GUS_VACCINATED_MASKED_INFECTED:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool is_vaccinated(uint8_t state)
+{
+	switch (state) {
+	case BT_MESH_GUS_VACCINATED:
+	case BT_MESH_GUS_VACCINATED_INFECTED:
+	case BT_MESH_GUS_VACCINATED_MASKED:
+	case BT_MESH_GUS_VACCINATED_MASKED_INFECTED:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// the infected counterpart of a state that can be infected
+static uint8_t infected(uint8_t state)
+{
+	switch (state) {
+	case BT_MESH_GUS_HEALTHY:
+		return BT_MESH_GUS_INFECTED;
+	case BT_MESH_GUS_MASKED:
+		return BT_MESH_GUS_MASKED_INFECTED;
+	case BT_MESH_GUS_VACCINATED:
+		return BT_MESH_GUS_VACCINATED_INFECTED;
+	case BT_MESH_GUS_VACCINATED_MASKED:
+		return BT_MESH_GUS_VACCINATED_MASKED_INFECTED;
+	default:
+		return state;
+	}
+}
+
+static uint32_t band_risk(int8_t rssi)
+{
+	if (rssi >= CONFIG_GUS_EXPOSURE_RSSI_NEAR) {
+		return CONFIG_GUS_SPREAD_NEAR_PERMILLE;
+	}
+	if (rssi >= CONFIG_GUS_EXPOSURE_RSSI_MID) {
+		return CONFIG_GUS_SPREAD_MID_PERMILLE;
+	}
+	if (rssi >= CONFIG_GUS_EXPOSURE_RSSI_FAR) {
+		return CONFIG_GUS_SPREAD_FAR_PERMILLE;
+	}
+	return 0;
+}
+
+static uint32_t risk(const struct source *source, uint8_t state)
+{
+	uint32_t permille = band_risk(source->rssi);
+
+	if (source->masked) {
+		permille = permille * CONFIG_GUS_SPREAD_MASK_PERMILLE / PERMILLE;
+	}
+	if (is_masked(state)) {
+		permille = permille * CONFIG_GUS_SPREAD_MASK_PERMILLE / PERMILLE;
+	}
+	if (is_vaccinated(state)) {
+		permille = permille * CONFIG_GUS_SPREAD_VACCINE_PERMILLE /
+			   PERMILLE;
+	}
+
+	return permille;
+}
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+bool gus_spread_is_infected(uint8_t state)
+{
+	switch (state) {
+	case BT_MESH_GUS_INFECTED:
+	case BT_MESH_GUS_MASKED_INFECTED:
+	case BT_MESH_GUS_VACCINATED_INFECTED:
+	case BT_MESH_GUS_VACCINATED_MASKED_INFECTED:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void gus_spread_heard(uint16_t addr, int8_t rssi, uint8_t state)
+{
+	if (!gus_spread_is_infected(state)) {
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	size_t i;
+
+	for (i = 0; i < source_count && sources[i].addr != addr; ++i) {
+	}
+
+	if (i < source_count) {
+		sources[i].rssi = MAX(sources[i].rssi, rssi);
+	} else if (source_count < ARRAY_SIZE(sources)) {
+		sources[source_count++] = (struct source) {
+			.addr = addr,
+			.rssi = rssi,
+			.masked = is_masked(state),
+		};
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+enum bt_mesh_gus_state gus_spread_round(enum bt_mesh_gus_state state)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	bool infect = false;
+
+	// one independent chance per source, stop at the first hit
+	for (size_t i = 0; i < source_count && !infect; ++i) {
+		infect = (sys_rand32_get() % PERMILLE) < risk(&sources[i], state);
+	}
+	source_count = 0;
+
+	k_spin_unlock(&lock, key);
+
+	return infect ? infected(state) : state;
+}
+
+#else
+
+bool gus_spread_is_infected(uint8_t state)
+{
+	return false;
+}
+
+void gus_spread_heard(uint16_t addr, int8_t rssi, uint8_t state)
+{
+}
+
+enum bt_mesh_gus_state gus_spread_round(enum bt_mesh_gus_state state)
+{
+	return state;
+}
+
+#endif /* CONFIG_GUS_SPREAD */
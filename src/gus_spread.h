@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus on-device infection spread
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// Infection spread - every badge runs the simulation for itself.
+//
+// With CONFIG_GUS_SPREAD the Check Proximity beacon carries the state of
+// the sender.  During a proximity round the badge remembers the infected
+// badges it heard directly, with their strongest rssi.  At the end of the
+// round each of them is one chance of infection, with a per mille risk
+// picked by rssi band (the GUS_EXPOSURE_RSSI_* levels) and lowered by a
+// mask on either side and by vaccination of the receiver.  A contact that
+// lasts longer is heard in more rounds and so gets more chances.
+//
+// An infected badge stays infected until the client sets another state.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GUS_SPREAD_H__
+#define GUS_SPREAD_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gus_svr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Check whether a state spreads the infection.
+ *
+ *  @param state State of a badge.
+ *
+ *  @return true for the infected states.
+ */
+bool gus_spread_is_infected(uint8_t state);
+
+/** @brief Record a Check Proximity beacon heard directly.
+ *
+ *  @param addr  Unicast address of the sender.
+ *  @param rssi  Rssi of the beacon.
+ *  @param state State of the sender, BT_MESH_GUS_STATE_UNCHANGED if the
+ *               beacon carried none.
+ */
+void gus_spread_heard(uint16_t addr, int8_t rssi, uint8_t state);
+
+/** @brief End the proximity round and apply the transmission rules.
+ *
+ *  @param state Current state of the badge.
+ *
+ *  @return New state of the badge, @p state if it did not change.
+ */
+enum bt_mesh_gus_state gus_spread_round(enum bt_mesh_gus_state state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_SPREAD_H__ */
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include "gus_stats.h"
+
+#ifdef CONFIG_GUS_STATS
+
+#define LATENCY_MIN_SHIFT 3     // bin 0 ends at 8 us
+
+static struct gus_stats_op stats[GUS_STATS_OPS];
+static struct k_spinlock lock;
+
+static uint8_t latency_bin(uint64_t ns)
+{
+	uint32_t us = MIN(ns / 1000, UINT32_MAX);
+	int bin = 0;
+
+	us >>= LATENCY_MIN_SHIFT;
+	while (us && bin < GUS_STATS_LATENCY_BINS - 1) {
+		us >>= 1;
+		bin++;
+	}
+
+	return bin;
+}
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+void gus_stats_init(void)
+{
+	timing_init();
+	timing_start();
+}
+
+timing_t gus_stats_begin(void)
+{
+	return timing_counter_get();
+}
+
+void gus_stats_rx(uint32_t op, timing_t start)
+{
+	timing_t end = timing_counter_get();
+	uint8_t num = GUS_STATS_OP_NUM(op);
+	uint8_t bin;
+
+	if (num >= GUS_STATS_OPS) {
+		return;
+	}
+
+	bin = latency_bin(timing_cycles_to_ns(timing_cycles_get(&start, &end)));
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	stats[num].rx++;
+	if (stats[num].latency[bin] < UINT16_MAX) {
+		stats[num].latency[bin]++;
+	}
+	k_spin_unlock(&lock, key);
+}
+
+void gus_stats_tx(uint32_t op, int err)
+{
+	uint8_t num = GUS_STATS_OP_NUM(op);
+
+	if (num >= GUS_STATS_OPS) {
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (err) {
+		stats[num].tx_err++;
+	} else {
+		stats[num].tx++;
+	}
+	k_spin_unlock(&lock, key);
+}
+
+int gus_stats_get(uint8_t num, struct gus_stats_op *op)
+{
+	if (num >= GUS_STATS_OPS) {
+		return -EINVAL;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	*op = stats[num];
+	k_spin_unlock(&lock, key);
+
+	return 0;
+}
+
+void gus_stats_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	memset(stats, 0, sizeof(stats));
+	k_spin_unlock(&lock, key);
+}
+
+#else
+
+void gus_stats_init(void)
+{
+}
+
+timing_t gus_stats_begin(void)
+{
+	return 0;
+}
+
+void gus_stats_rx(uint32_t op, timing_t start)
+{
+}
+
+void gus_stats_tx(uint32_t op, int err)
+{
+}
+
+int gus_stats_get(uint8_t num, struct gus_stats_op *op)
+{
+	return -ENOTSUP;
+}
+
+void gus_stats_reset(void)
+{
+}
+
+#endif /* CONFIG_GUS_STATS */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus message statistics
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// Message statistics - per opcode counters for the Gus server.
+//
+// Every received Gus message is counted, and the time its handler takes is
+// measured with the cycle counter (the timing API) and sorted into a log2
+// histogram.  Every sent or published message is counted, as is every
+// bt_mesh_model_send() / bt_mesh_model_publish() that fails.
+//
+// Opcodes are identified by their number, the first byte of the three
+// byte vendor opcode (0x04 for Sign in and so on).  The statistics are read
+// with the Stats get message (gus_svr.h) or the "gus stats" shell command.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GUS_STATS_H__
+#define GUS_STATS_H__
+
+#include <stdint.h>
+#include <timing/timing.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of opcode numbers statistics are kept for. */
+#define GUS_STATS_OPS 32
+
+/** Number of handler latency histogram bins. Bin 0 counts handlers that
+ *  took less than 8 us, bin n those that took 2^(n+2) to 2^(n+3) us, and
+ *  the last bin all slower ones.
+ */
+#define GUS_STATS_LATENCY_BINS 8
+
+/** Opcode number of a Gus vendor opcode. */
+#define GUS_STATS_OP_NUM(op) (((op) >> 16) & 0x3f)
+
+/** Statistics of one opcode. */
+struct gus_stats_op {
+	uint32_t rx;
+	uint32_t tx;
+	uint32_t tx_err;
+	uint16_t latency[GUS_STATS_LATENCY_BINS];
+};
+
+/** @brief Start the cycle counter. */
+void gus_stats_init(void);
+
+/** @brief Mark the start of a message handler.
+ *
+ *  @return Cycle counter value to pass to gus_stats_rx().
+ */
+timing_t gus_stats_begin(void);
+
+/** @brief Count a received message and the time its handler took.
+ *
+ *  @param op    Opcode of the message.
+ *  @param start Value of gus_stats_begin() before the handler ran.
+ */
+void gus_stats_rx(uint32_t op, timing_t start);
+
+/** @brief Count a sent message.
+ *
+ *  @param op  Opcode of the message.
+ *  @param err Return value of bt_mesh_model_send() or
+ *             bt_mesh_model_publish().
+ */
+void gus_stats_tx(uint32_t op, int err);
+
+/** @brief Read the statistics of an opcode.
+ *
+ *  @param num   Opcode number.
+ *  @param stats Statistics of the opcode.
+ *
+ *  @retval 0       The statistics were read.
+ *  @retval -EINVAL @p num is out of range.
+ */
+int gus_stats_get(uint8_t num, struct gus_stats_op *stats);
+
+/** @brief Clear all statistics. */
+void gus_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_STATS_H__ */
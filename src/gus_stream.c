@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include "gus_stream.h"
+
+#ifdef CONFIG_GUS_STREAM
+
+#include <sys/byteorder.h>
+#include <sys/crc.h>
+
+#if defined(CONFIG_GUS_STREAM_RTT)
+#include <SEGGER_RTT.h>
+
+BUILD_ASSERT(CONFIG_GUS_STREAM_RTT_CHANNEL > 0 &&
+	     CONFIG_GUS_STREAM_RTT_CHANNEL < CONFIG_SEGGER_RTT_MAX_NUM_UP_BUFFERS,
+	     "The stream needs an RTT up channel of its own");
+#else
+#include <device.h>
+#include <drivers/uart.h>
+#endif
+
+#define HEADER_LEN 7
+#define CRC_LEN    2
+#define BODY_MAX   (3 + NUM_PROXIMITY_REPORTS * 4)    // the report
+#define RECORD_MAX (HEADER_LEN + BODY_MAX + CRC_LEN)
+// COBS adds one byte per 254, plus the delimiters
+#define FRAME_MAX  (RECORD_MAX + RECORD_MAX / 254 + 3)
+
+BUILD_ASSERT(CONFIG_BT_MESH_GUS_NAME_LENGTH + 2 <= BODY_MAX,
+	     "A sign-in must fit in a record.");
+
+struct record {
+	uint8_t len;
+	uint8_t data[RECORD_MAX];
+};
+
+K_MSGQ_DEFINE(records, sizeof(struct record), CONFIG_GUS_STREAM_QUEUE, 4);
+
+static atomic_t seq;
+static atomic_t dropped;
+
+#if defined(CONFIG_GUS_STREAM_RTT)
+static uint8_t rtt_buf[CONFIG_GUS_STREAM_RTT_BUFFER_SIZE];
+
+static bool channel_init(void)
+{
+	// skipped whole when it does not fit, a host that is not attached
+	// never blocks the thread
+	return SEGGER_RTT_ConfigUpBuffer(CONFIG_GUS_STREAM_RTT_CHANNEL,
+					 "gus_stream", rtt_buf, sizeof(rtt_buf),
+					 SEGGER_RTT_MODE_NO_BLOCK_SKIP) >= 0;
+}
+
+static void channel_write(const uint8_t *frame, size_t len)
+{
+	if (!SEGGER_RTT_Write(CONFIG_GUS_STREAM_RTT_CHANNEL, frame, len)) {
+		atomic_inc(&dropped);
+	}
+}
+#else
+static const struct device *uart = DEVICE_DT_GET(DT_CHOSEN(gus_stream_uart));
+
+static bool channel_init(void)
+{
+	return device_is_ready(uart);
+}
+
+static void channel_write(const uint8_t *frame, size_t len)
+{
+	for (size_t i = 0; i < len; ++i) {
+		uart_poll_out(uart, frame[i]);
+	}
+}
+#endif
+
+static uint8_t *begin(struct record *rec, enum gus_stream_type type)
+{
+	rec->data[0] = type;
+	sys_put_le16(atomic_inc(&seq), &rec->data[1]);
+	sys_put_le32(k_uptime_get_32(), &rec->data[3]);
+	rec->len = HEADER_LEN;
+
+	return &rec->data[HEADER_LEN];
+}
+
+static void end(struct record *rec, size_t body_len)
+{
+	rec->len += body_len;
+	sys_put_le16(crc16_itu_t(0xffff, rec->data, rec->len),
+		     &rec->data[rec->len]);
+	rec->len += CRC_LEN;
+
+	if (k_msgq_put(&records, rec, K_NO_WAIT)) {
+		atomic_inc(&dropped);
+	}
+}
+
+// Consistent Overhead Byte Stuffing, removes every 0x00 from the record
+static size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+	size_t code_pos = 0;
+	size_t pos = 1;
+	uint8_t code = 1;
+
+	for (size_t i = 0; i < len; ++i) {
+		if (in[i]) {
+			out[pos++] = in[i];
+			code++;
+		}
+		if (!in[i] || code == 0xff) {
+			out[code_pos] = code;
+			code_pos = pos++;
+			code = 1;
+		}
+	}
+	out[code_pos] = code;
+
+	return pos;
+}
+
+static void stream_thread(void)
+{
+	struct record rec;
+	uint8_t frame[FRAME_MAX];
+
+	if (!channel_init()) {
+		return;
+	}
+
+	while (1) {
+		size_t len;
+
+		k_msgq_get(&records, &rec, K_FOREVER);
+
+		frame[0] = 0x00;
+		len = 1 + cobs_encode(rec.data, rec.len, &frame[1]);
+		frame[len++] = 0x00;
+
+		channel_write(frame, len);
+	}
+}
+
+K_THREAD_DEFINE(gus_stream, 1024, stream_thread, NULL, NULL, NULL,
+		K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+void gus_stream_sign_in(uint16_t addr, const char *name)
+{
+	struct record rec;
+	uint8_t *body = begin(&rec, GUS_STREAM_SIGN_IN);
+	size_t len = strnlen(name, CONFIG_BT_MESH_GUS_NAME_LENGTH);
+
+	sys_put_le16(addr, body);
+	memcpy(&body[2], name, len);
+	end(&rec, 2 + len);
+}
+
+void gus_stream_report(uint16_t reporter, const struct gus_report_data *report,
+		       size_t count)
+{
+	struct record rec;
+	uint8_t *body = begin(&rec, GUS_STREAM_REPORT);
+
+	count = MIN(count, NUM_PROXIMITY_REPORTS);
+
+	sys_put_le16(reporter, body);
+	body[2] = count;
+	for (size_t i = 0; i < count; ++i) {
+		uint8_t *entry = &body[3 + 4 * i];
+
+		sys_put_le16(report[i].addr, entry);
+		entry[2] = report[i].rssi;
+		entry[3] = report[i].confidence;
+	}
+	end(&rec, 3 + 4 * count);
+}
+
+void gus_stream_state(uint16_t addr, uint8_t state)
+{
+	struct record rec;
+	uint8_t *body = begin(&rec, GUS_STREAM_STATE);
+
+	sys_put_le16(addr, body);
+	body[2] = state;
+	end(&rec, 3);
+}
+
+void gus_stream_status(uint16_t addr, const struct bt_mesh_gus_status *status)
+{
+	struct record rec;
+	uint8_t *body = begin(&rec, GUS_STREAM_STATUS);
+
+	sys_put_le16(addr, body);
+	body[2] = status->state;
+	sys_put_le16(status->name_hash, &body[3]);
+	body[5] = status->neighbors;
+	body[6] = status->contacts;
+	end(&rec, 7);
+}
+
+void gus_stream_timeout(uint16_t addr)
+{
+	struct record rec;
+	uint8_t *body = begin(&rec, GUS_STREAM_TIMEOUT);
+
+	sys_put_le16(addr, body);
+	end(&rec, 2);
+}
+
+uint32_t gus_stream_dropped(void)
+{
+	return atomic_get(&dropped);
+}
+
+#else
+
+void gus_stream_sign_in(uint16_t addr, const char *name)
+{
+}
+
+void gus_stream_report(uint16_t reporter, const struct gus_report_data *report,
+		       size_t count)
+{
+}
+
+void gus_stream_state(uint16_t addr, uint8_t state)
+{
+}
+
+void gus_stream_status(uint16_t addr, const struct bt_mesh_gus_status *status)
+{
+}
+
+void gus_stream_timeout(uint16_t addr)
+{
+}
+
+uint32_t gus_stream_dropped(void)
+{
+	return 0;
+}
+
+#endif /* CONFIG_GUS_STREAM */
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus binary record stream
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// Record stream - machine readable output of a collecting badge.
+//
+// Every record is one frame on a channel of its own, an RTT up channel or
+// a spare UART (CONFIG_GUS_STREAM_CHANNEL), never the console UART that
+// the shell and the log write to:
+//   0x00  COBS(record)  0x00
+// and the record, before COBS encoding, is
+//   type     (1 byte)  GUS_STREAM_*
+//   seq      (2 bytes) sequence number, a gap means lost records
+//   time_ms  (4 bytes) uptime of the badge
+//   body     (0..n)    depends on the type, see below
+//   crc      (2 bytes) CRC-16/CCITT-FALSE of type to body
+// All fields are little endian.  A decoder splits the input at 0x00 and
+// drops everything that fails to decode or fails the CRC, such as a frame
+// cut short when the capture started.  tools/gus_stream.py turns the
+// stream into NDJSON or CSV.
+//
+// Bodies:
+//   SIGN_IN  addr (2), name (up to CONFIG_BT_MESH_GUS_NAME_LENGTH bytes)
+//   REPORT   reporter (2), count (1), count times addr (2), rssi (1),
+//            confidence (1)
+//   STATE    addr (2), state (1) - the state of this badge changed
+//   STATUS   addr (2), state (1), name_hash (2), neighbors (1),
+//            contacts (1)
+//   TIMEOUT  addr (2) - the badge did not reply
+//
+// Records are queued by the caller and written by a low priority thread,
+// so the mesh threads never wait for the channel.  A record that does not
+// fit in the queue, or in the RTT buffer, is dropped, and its sequence
+// number is skipped.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GUS_STREAM_H__
+#define GUS_STREAM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "gus_svr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum gus_stream_type {
+	GUS_STREAM_SIGN_IN = 1,
+	GUS_STREAM_REPORT,
+	GUS_STREAM_STATE,
+	GUS_STREAM_STATUS,
+	GUS_STREAM_TIMEOUT,
+};
+
+/** @brief Stream a sign-in reply.
+ *
+ * @param addr Address of the badge.
+ * @param name Name of the badge.
+ */
+void gus_stream_sign_in(uint16_t addr, const char *name);
+
+/** @brief Stream a report.
+ *
+ * @param reporter Address of the reporting badge.
+ * @param report   Report entries, at most NUM_PROXIMITY_REPORTS are sent.
+ * @param count    Number of entries in @p report.
+ */
+void gus_stream_report(uint16_t reporter, const struct gus_report_data *report,
+		       size_t count);
+
+/** @brief Stream a state change of this badge.
+ *
+ * @param addr  Address of this badge.
+ * @param state New state.
+ */
+void gus_stream_state(uint16_t addr, uint8_t state);
+
+/** @brief Stream a status published by a badge.
+ *
+ * @param addr   Address of the badge.
+ * @param status Status of the badge.
+ */
+void gus_stream_status(uint16_t addr, const struct bt_mesh_gus_status *status);
+
+/** @brief Stream a badge that did not reply.
+ *
+ * @param addr Address of the badge.
+ */
+void gus_stream_timeout(uint16_t addr);
+
+/** @brief Get the number of dropped records.
+ *
+ * @return Records dropped because the queue was full.
+ */
+uint32_t gus_stream_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_STREAM_H__ */
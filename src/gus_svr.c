@@ -6,9 +6,13 @@
 
 #include <bluetooth/mesh.h>
 #include "gus_svr.h"
+#include "tx_power.h"
+#include "gus_energy.h"
+#include "gus_tx.h"
 #include "mesh/net.h"
 #include "mesh/transport.h"
 #include <string.h>
+#include <settings/settings.h>
 #include <logging/log.h>
 #include <drivers/gpio.h>
 
@@ -32,6 +36,57 @@ BUILD_ASSERT(BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_REPORT_REPLY,
 				 BT_MESH_TX_SDU_MAX,
 			 "The report reply message must fit inside an application SDU.");
 
+BUILD_ASSERT(BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_REPORT_COMPACT_REPLY,
+								   BT_MESH_GUS_MSG_MAXLEN_REPORT_COMPACT_REPLY) <=
+				 BT_MESH_TX_SDU_MAX,
+			 "The compact report reply message must fit inside an application SDU.");
+
+BUILD_ASSERT(BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_EXPOSURE_REPLY,
+								   BT_MESH_GUS_MSG_MAXLEN_EXPOSURE_REPLY) <=
+				 BT_MESH_TX_SDU_MAX,
+			 "The exposure reply message must fit inside an application SDU.");
+
+BUILD_ASSERT(BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_STATS_REPLY,
+								   BT_MESH_GUS_MSG_LEN_STATS_REPLY) <=
+				 BT_MESH_TX_SDU_MAX,
+			 "The stats reply message must fit inside an application SDU.");
+
+BUILD_ASSERT(BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_TELEMETRY_REPLY,
+								   BT_MESH_GUS_MSG_LEN_TELEMETRY_REPLY) <=
+				 BT_MESH_TX_SDU_MAX,
+			 "The telemetry reply message must fit inside an application SDU.");
+
+BUILD_ASSERT(BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_SET_STATES,
+								   BT_MESH_GUS_MSG_MAXLEN_SET_STATES) <=
+				 BT_MESH_TX_SDU_MAX,
+			 "The set states message must fit inside an application SDU.");
+BUILD_ASSERT(BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_SET_STATES,
+								   BT_MESH_GUS_MSG_MAXLEN_SET_STATES) <=
+				 BT_MESH_RX_SDU_MAX,
+			 "A full set states message must be received, raise "
+			 "CONFIG_BT_MESH_RX_SEG_MAX.");
+
+BUILD_ASSERT(BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_STATUS,
+								   BT_MESH_GUS_MSG_LEN_STATUS) <=
+				 BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_SET_NAME,
+									   BT_MESH_GUS_MSG_MAXLEN_MESSAGE),
+			 "The status message must fit inside the publication buffer.");
+
+BUILD_ASSERT(BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_LOG_REPLY,
+								   BT_MESH_GUS_MSG_MAXLEN_LOG_REPLY) <=
+				 BT_MESH_TX_SDU_MAX,
+			 "The log reply message must fit inside an application SDU.");
+
+BUILD_ASSERT(BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_LOG_REPLY,
+								   BT_MESH_GUS_MSG_MAXLEN_LOG_REPLY) <=
+				 CONFIG_GUS_TX_BUF_SIZE,
+			 "The log reply message must fit in an outbound queue entry.");
+
+BUILD_ASSERT(BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_EXPOSURE_REPLY,
+								   BT_MESH_GUS_MSG_MAXLEN_EXPOSURE_REPLY) <=
+				 CONFIG_GUS_TX_BUF_SIZE,
+			 "The exposure reply message must fit in an outbound queue entry.");
+
 /////////////////////
 // Static functions
 /////////////////////
@@ -44,6 +99,118 @@ static const uint8_t *extract_name(struct net_buf_simple *buf)
 	return net_buf_simple_pull_mem(buf, buf->len);
 }
 
+// TTL the mesh sends a publication with
+static uint8_t pub_ttl(const struct bt_mesh_model_pub *pub)
+{
+	return pub->ttl == BT_MESH_TTL_DEFAULT ? bt_mesh_default_ttl_get() :
+											 pub->ttl;
+}
+
+// queue a message, the outbound queue counts it for the statistics
+static int model_send(struct bt_mesh_gus *gus, struct bt_mesh_msg_ctx *ctx,
+					  struct net_buf_simple *msg, uint32_t op)
+{
+	return gus_tx_send(gus->model, ctx, msg, op);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Persistence
+// The state and name are written to flash as one record.  The first change
+// starts the store timer and later changes ride along with it, so a burst
+// of set state and set name messages costs at most one flash write per
+// CONFIG_GUS_STORE_DELAY_MS.
+//////////////////////////////////////////////////////////////////////
+struct gus_stored
+{
+	uint8_t state;
+	uint8_t name[CONFIG_BT_MESH_GUS_NAME_LENGTH + 1];
+} __packed;
+
+static void store_work_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct bt_mesh_gus *gus = CONTAINER_OF(dwork, struct bt_mesh_gus,
+										   store_work);
+	struct gus_stored stored = {
+		.state = gus->state,
+	};
+	int err;
+
+	memcpy(stored.name, gus->name, sizeof(stored.name));
+
+	err = bt_mesh_model_data_store(gus->model, true, NULL, &stored,
+								   sizeof(stored));
+	if (err)
+	{
+		LOG_WRN("Storing state failed (err %d)", err);
+	}
+}
+
+static void schedule_store(struct bt_mesh_gus *gus)
+{
+#ifdef CONFIG_BT_SETTINGS
+	// keeps a pending deadline, unlike k_work_reschedule
+	k_work_schedule(&gus->store_work, K_MSEC(CONFIG_GUS_STORE_DELAY_MS));
+#endif
+}
+
+static void beacon_end(int err, void *cb_data)
+{
+	tx_power_beacon_end();
+}
+
+static const struct bt_mesh_send_cb beacon_cb = {
+	.end = beacon_end,
+};
+
+// The beacon is its own message, not the periodic publication: it goes to
+// the publish address with TTL 0, so no relay repeats it and there are no
+// publication retransmits.  Called by the outbound queue from the system
+// work queue; with CONFIG_GUS_BEACON_TX_POWER_CTRL the tx power is lowered
+// first and restored when the mesh is done sending it.
+static int beacon_send(void *arg)
+{
+	struct bt_mesh_gus *gus = arg;
+	struct bt_mesh_model_pub *pub = gus->model->pub;
+	struct bt_mesh_msg_ctx ctx = {
+		// the subnet follows from the application key
+		.app_idx = pub->key,
+		.addr = pub->addr,
+		.send_ttl = 0,
+	};
+	BT_MESH_MODEL_BUF_DEFINE(msg, BT_MESH_GUS_OP_CHECK_PROXIMITY,
+							 BT_MESH_GUS_MSG_MAXLEN_CHECK_PROXIMITY);
+	int err;
+
+	if (pub->addr == BT_MESH_ADDR_UNASSIGNED)
+	{
+		return -EADDRNOTAVAIL;
+	}
+
+	bt_mesh_model_msg_init(&msg, BT_MESH_GUS_OP_CHECK_PROXIMITY);
+	if (IS_ENABLED(CONFIG_GUS_SPREAD))
+	{
+		net_buf_simple_add_u8(&msg, gus->state);
+	}
+
+	// the power command is in the HCI queue before the beacon, a beacon
+	// at full power would skew the proximity of every receiver
+	err = tx_power_beacon_begin();
+	if (!err)
+	{
+		err = bt_mesh_model_send(gus->model, &ctx, &msg, &beacon_cb, NULL);
+	}
+
+	if (err)
+	{
+		tx_power_beacon_end();
+		return err;
+	}
+
+	gus_energy_tx(msg.len);
+	return 0;
+}
+
 ////////////////////
 // message handlers
 ///////////////////
@@ -52,16 +219,36 @@ static void handle_sign_in(struct bt_mesh_model *model,
 						   struct bt_mesh_msg_ctx *ctx,
 						   struct net_buf_simple *buf)
 {
-
 	struct bt_mesh_gus *gus = model->user_data;
 
 	uint16_t addr = bt_mesh_model_elem(model)->addr;
+
 	if (gus->handlers->sign_in)
 	{
 		gus->handlers->sign_in(gus, ctx, addr);
 	}
 }
 
+static bool state_valid(uint8_t state)
+{
+	return state <= BT_MESH_GUS_OFF;
+}
+
+static void set_state(struct bt_mesh_gus *gus, struct bt_mesh_msg_ctx *ctx,
+					  enum bt_mesh_gus_state state)
+{
+	if (gus->state != state)
+	{
+		gus->state = state;
+		schedule_store(gus);
+	}
+
+	if (gus->handlers->set_state)
+	{
+		gus->handlers->set_state(gus, ctx, state);
+	}
+}
+
 static void handle_set_state(struct bt_mesh_model *model,
 							 struct bt_mesh_msg_ctx *ctx,
 							 struct net_buf_simple *buf)
@@ -70,10 +257,36 @@ static void handle_set_state(struct bt_mesh_model *model,
 	enum bt_mesh_gus_state state;
 
 	state = net_buf_simple_pull_u8(buf);
+	if (!state_valid(state))
+	{
+		return;
+	}
 
-	if (gus->handlers->set_state)
+	set_state(gus, ctx, state);
+}
+
+static void handle_set_states(struct bt_mesh_model *model,
+							  struct bt_mesh_msg_ctx *ctx,
+							  struct net_buf_simple *buf)
+{
+	struct bt_mesh_gus *gus = model->user_data;
+	uint16_t base = net_buf_simple_pull_le16(buf);
+	uint16_t offset = bt_mesh_model_elem(model)->addr - base;
+	uint8_t state;
+
+	// wraps around for addresses below base
+	if (offset >= buf->len * 2)
 	{
-		gus->handlers->set_state(gus, ctx, state);
+		return;
+	}
+
+	state = buf->data[offset / 2];
+	state = (offset & 1) ? (state >> 4) : (state & 0xf);
+
+	// BT_MESH_GUS_STATE_UNCHANGED, and the unused values, leave it alone
+	if (state_valid(state))
+	{
+		set_state(gus, ctx, state);
 	}
 }
 
@@ -86,7 +299,13 @@ static void handle_set_name(struct bt_mesh_model *model,
 
 	msg = extract_name(buf);
 
-	strncpy(gus->name, msg, CONFIG_BT_MESH_GUS_NAME_LENGTH);
+	if (strncmp(gus->name, msg, CONFIG_BT_MESH_GUS_NAME_LENGTH))
+	{
+		strncpy(gus->name, msg, CONFIG_BT_MESH_GUS_NAME_LENGTH);
+		gus->sign_in_len = 0;
+		schedule_store(gus);
+	}
+
 	if (gus->handlers->set_name)
 	{
 		gus->handlers->set_name(gus, ctx, msg);
@@ -105,19 +324,137 @@ static void handle_report_request(struct bt_mesh_model *model,
 	}
 }
 
+static void handle_report_compact_request(struct bt_mesh_model *model,
+										  struct bt_mesh_msg_ctx *ctx,
+										  struct net_buf_simple *buf)
+{
+	struct bt_mesh_gus *gus = model->user_data;
+
+	if (gus->handlers->report_compact_request)
+	{
+		gus->handlers->report_compact_request(gus, ctx);
+	}
+}
+
+static void handle_exposure_request(struct bt_mesh_model *model,
+									struct bt_mesh_msg_ctx *ctx,
+									struct net_buf_simple *buf)
+{
+	struct bt_mesh_gus *gus = model->user_data;
+	uint16_t after = 0;
+
+	if (buf->len >= 2)
+	{
+		after = net_buf_simple_pull_le16(buf);
+	}
+
+	if (gus->handlers->exposure_request)
+	{
+		gus->handlers->exposure_request(gus, ctx, after);
+	}
+}
+
+static void handle_log_get(struct bt_mesh_model *model,
+						   struct bt_mesh_msg_ctx *ctx,
+						   struct net_buf_simple *buf)
+{
+	struct bt_mesh_gus *gus = model->user_data;
+	uint32_t after = net_buf_simple_pull_le32(buf);
+	uint8_t count = net_buf_simple_pull_u8(buf);
+
+	if (gus->handlers->log_get)
+	{
+		gus->handlers->log_get(gus, ctx, after, count);
+	}
+}
+
+static void handle_stats_get(struct bt_mesh_model *model,
+							 struct bt_mesh_msg_ctx *ctx,
+							 struct net_buf_simple *buf)
+{
+	struct bt_mesh_gus *gus = model->user_data;
+	uint8_t op = net_buf_simple_pull_u8(buf);
+
+	if (gus->handlers->stats_get)
+	{
+		gus->handlers->stats_get(gus, ctx, op);
+	}
+}
+
+static void handle_telemetry_get(struct bt_mesh_model *model,
+								 struct bt_mesh_msg_ctx *ctx,
+								 struct net_buf_simple *buf)
+{
+	struct bt_mesh_gus *gus = model->user_data;
+
+	if (gus->handlers->telemetry_get)
+	{
+		gus->handlers->telemetry_get(gus, ctx);
+	}
+}
+
+// the status of another badge, a passive proximity sample when it was
+// received with the TTL it was published with, so no relay forwarded it
+static void handle_status(struct bt_mesh_model *model,
+						  struct bt_mesh_msg_ctx *ctx,
+						  struct net_buf_simple *buf)
+{
+	struct bt_mesh_gus *gus = model->user_data;
+	uint8_t ttl;
+
+	net_buf_simple_pull(buf, BT_MESH_GUS_MSG_LEN_STATUS - 1);
+	ttl = net_buf_simple_pull_u8(buf);
+
+	if (IS_ENABLED(CONFIG_GUS_PASSIVE_PROXIMITY) &&
+		ctx->recv_ttl == ttl && gus->handlers->overheard)
+	{
+		gus->handlers->overheard(gus, ctx);
+	}
+}
+
 static void handle_check_proximity(struct bt_mesh_model *model,
 								   struct bt_mesh_msg_ctx *ctx,
 								   struct net_buf_simple *buf)
 {
 	struct bt_mesh_gus *gus = model->user_data;
 	uint16_t addr = bt_mesh_model_elem(model)->addr;
+	uint8_t state = BT_MESH_GUS_STATE_UNCHANGED;
+
+	if (buf->len)
+	{
+		state = net_buf_simple_pull_u8(buf);
+	}
 
 	if (gus->handlers->check_proximity)
 	{
-		gus->handlers->check_proximity(gus, ctx, addr);
+		gus->handlers->check_proximity(gus, ctx, addr, state);
 	}
 }
 
+// count a received message and time its handler
+#define TIMED_HANDLER(_handler, _op)                          \
+	static void _handler##_timed(struct bt_mesh_model *model, \
+				     struct bt_mesh_msg_ctx *ctx,   \
+				     struct net_buf_simple *buf)    \
+	{                                                         \
+		timing_t start = gus_stats_begin();               \
+		_handler(model, ctx, buf);                        \
+		gus_stats_rx(_op, start);                         \
+	}
+
+TIMED_HANDLER(handle_sign_in, BT_MESH_GUS_OP_SIGN_IN)
+TIMED_HANDLER(handle_set_state, BT_MESH_GUS_OP_SET_STATE)
+TIMED_HANDLER(handle_set_states, BT_MESH_GUS_OP_SET_STATES)
+TIMED_HANDLER(handle_set_name, BT_MESH_GUS_OP_SET_NAME)
+TIMED_HANDLER(handle_report_request, BT_MESH_GUS_OP_REPORT)
+TIMED_HANDLER(handle_check_proximity, BT_MESH_GUS_OP_CHECK_PROXIMITY)
+TIMED_HANDLER(handle_report_compact_request, BT_MESH_GUS_OP_REPORT_COMPACT)
+TIMED_HANDLER(handle_exposure_request, BT_MESH_GUS_OP_EXPOSURE)
+TIMED_HANDLER(handle_log_get, BT_MESH_GUS_OP_LOG_GET)
+TIMED_HANDLER(handle_stats_get, BT_MESH_GUS_OP_STATS_GET)
+TIMED_HANDLER(handle_telemetry_get, BT_MESH_GUS_OP_TELEMETRY_GET)
+TIMED_HANDLER(handle_status, BT_MESH_GUS_OP_STATUS)
+
 ////////////////////
 // message handler table
 ///////////////////
@@ -125,62 +462,137 @@ static void handle_check_proximity(struct bt_mesh_model *model,
 const struct bt_mesh_model_op _bt_mesh_gus_svr_op[] = {
 	{BT_MESH_GUS_OP_SIGN_IN,
 	 BT_MESH_GUS_MSG_LEN_REQUEST,
-	 handle_sign_in},
+	 handle_sign_in_timed},
 	{BT_MESH_GUS_OP_SET_STATE,
 	 BT_MESH_GUS_MSG_MINLEN_MESSAGE,
-	 handle_set_state},
+	 handle_set_state_timed},
+	{BT_MESH_GUS_OP_SET_STATES,
+	 BT_MESH_GUS_MSG_MINLEN_SET_STATES,
+	 handle_set_states_timed},
 	{BT_MESH_GUS_OP_SET_NAME,
 	 BT_MESH_GUS_MSG_MINLEN_MESSAGE,
-	 handle_set_name},
+	 handle_set_name_timed},
 	{BT_MESH_GUS_OP_REPORT,
 	 BT_MESH_GUS_MSG_LEN_REQUEST,
-	 handle_report_request},
+	 handle_report_request_timed},
 	{BT_MESH_GUS_OP_CHECK_PROXIMITY,
 	 BT_MESH_GUS_MSG_LEN_REQUEST,
-	 handle_check_proximity},
+	 handle_check_proximity_timed},
+	{BT_MESH_GUS_OP_REPORT_COMPACT,
+	 BT_MESH_GUS_MSG_LEN_REQUEST,
+	 handle_report_compact_request_timed},
+	{BT_MESH_GUS_OP_EXPOSURE,
+	 BT_MESH_GUS_MSG_LEN_REQUEST,
+	 handle_exposure_request_timed},
+	{BT_MESH_GUS_OP_LOG_GET,
+	 BT_MESH_GUS_MSG_LEN_LOG_GET,
+	 handle_log_get_timed},
+	{BT_MESH_GUS_OP_STATS_GET,
+	 BT_MESH_GUS_MSG_LEN_STATS_GET,
+	 handle_stats_get_timed},
+	{BT_MESH_GUS_OP_TELEMETRY_GET,
+	 BT_MESH_GUS_MSG_LEN_REQUEST,
+	 handle_telemetry_get_timed},
+	{BT_MESH_GUS_OP_STATUS,
+	 BT_MESH_GUS_MSG_LEN_STATUS,
+	 handle_status_timed},
 
 	BT_MESH_MODEL_OP_END,
 };
 
-//todo
+// Encodes the status into the publication message before every periodic
+// publication.
+static int bt_mesh_gus_svr_update_handler(struct bt_mesh_model *model)
+{
+	struct bt_mesh_gus *gus = model->user_data;
+	struct net_buf_simple *buf = model->pub->msg;
+	struct bt_mesh_gus_status status = {
+		.state = gus->state,
+		.name_hash = gus_core_name_hash(gus_core_sign_in_name(
+			(const char *)gus->name, bt_mesh_model_elem(model)->addr)),
+	};
+
+	if (gus->handlers->status)
+	{
+		gus->handlers->status(gus, &status);
+	}
 
-// static int bt_mesh_chat_cli_update_handler(struct bt_mesh_model *model)
-// {
-// struct bt_mesh_chat_cli *chat = model->user_data;
+	bt_mesh_model_msg_init(buf, BT_MESH_GUS_OP_STATUS);
+	net_buf_simple_add_u8(buf, status.state);
+	net_buf_simple_add_le16(buf, status.name_hash);
+	net_buf_simple_add_u8(buf, status.neighbors);
+	net_buf_simple_add_u8(buf, status.contacts);
+	net_buf_simple_add_u8(buf, pub_ttl(model->pub));
 
-// /* Continue publishing current presence. */
-// encode_presence(model->pub->msg, chat->presence);
+	// the mesh publishes right after, a failure is not reported back
+	gus_stats_tx(BT_MESH_GUS_OP_STATUS, 0);
+	gus_energy_tx(buf->len);
 
-// return 0;
-// }
+	return 0;
+}
 
 #ifdef CONFIG_BT_SETTINGS
+static int restore(struct bt_mesh_gus *gus, settings_read_cb read_cb,
+				   void *cb_arg)
+{
+	struct gus_stored stored;
+	ssize_t bytes = read_cb(cb_arg, &stored, sizeof(stored));
+	if (bytes < 0)
+	{
+		return bytes;
+	}
+
+	if (bytes == 0)
+	{
+		return 0;
+	}
+
+	if (bytes != sizeof(stored) || !state_valid(stored.state))
+	{
+		return -EINVAL;
+	}
+
+	gus->state = stored.state;
+	memcpy(gus->name, stored.name, sizeof(gus->name));
+	gus->name[CONFIG_BT_MESH_GUS_NAME_LENGTH] = '\0';
+	gus->sign_in_len = 0;
+
+	// settings are loaded before the mesh starts, so the badge shows its
+	// state right away instead of after provisioning data is committed
+	if (gus->handlers->restored)
+	{
+		gus->handlers->restored(gus);
+	}
+
+	return 0;
+}
+
 static int bt_mesh_gus_cli_settings_set(struct bt_mesh_model *model,
 										const char *name,
 										size_t len_rd,
 										settings_read_cb read_cb,
 										void *cb_arg)
 {
-	struct bt_mesh_gus *gus = model->user_data;
-
 	if (name)
 	{
 		return -ENOENT;
 	}
 
-	ssize_t bytes = read_cb(cb_arg, &gus->state,
-							sizeof(gus->state));
-	if (bytes < 0)
-	{
-		return bytes;
-	}
+	return restore(model->user_data, read_cb, cb_arg);
+}
+
+static int early_restore_cb(const char *key, size_t len,
+							settings_read_cb read_cb, void *cb_arg,
+							void *param)
+{
+	const char *next;
 
-	if (bytes != 0 && bytes != sizeof(gus->state))
+	if (!settings_name_steq(key, "data", &next) || next)
 	{
-		return -EINVAL;
+		return 0;
 	}
 
-	return 0;
+	return restore(param, read_cb, cb_arg);
 }
 #endif
 
@@ -194,7 +606,9 @@ static int bt_mesh_gus_svr_init(struct bt_mesh_model *model)
 								  sizeof(gus->buf));
 
 	gus->pub.msg = &gus->pub_msg;
-	gus->pub.update = NULL; //bt_mesh_gus_cli_update_handler;
+	gus->pub.update = bt_mesh_gus_svr_update_handler;
+	k_work_init_delayable(&gus->store_work, store_work_handler);
+	gus_stats_init();
 
 	return 0;
 }
@@ -216,9 +630,17 @@ static void bt_mesh_gus_svr_reset(struct bt_mesh_model *model)
 	struct bt_mesh_gus *gus = model->user_data;
 
 	gus->state = BT_MESH_GUS_HEALTHY;
+	memset(gus->name, 0, sizeof(gus->name));
+	gus->sign_in_len = 0;
+
+	if (gus->handlers->reset)
+	{
+		gus->handlers->reset(gus);
+	}
 
 	if (IS_ENABLED(CONFIG_BT_SETTINGS))
 	{
+		k_work_cancel_delayable(&gus->store_work);
 		(void)bt_mesh_model_data_store(model, true, NULL, NULL, 0);
 	}
 }
@@ -235,19 +657,32 @@ const struct bt_mesh_model_cb _bt_mesh_gus_svr_cb = {
 /////////////////////////////
 // public access functions
 /////////////////////////////
-int bt_mesh_gus_svr_sign_in_reply(struct bt_mesh_gus *gus,
-								  struct bt_mesh_msg_ctx *ctx,
-								  const uint8_t *name)
+int bt_mesh_gus_svr_sign_in_reply_cached(struct bt_mesh_gus *gus,
+										 struct bt_mesh_msg_ctx *ctx)
 {
-	BT_MESH_MODEL_BUF_DEFINE(msg, BT_MESH_GUS_OP_SIGN_IN_REPLY,
-							 BT_MESH_GUS_MSG_LEN_SIGN_IN_REPLY);
-	bt_mesh_model_msg_init(&msg, BT_MESH_GUS_OP_SIGN_IN_REPLY);
+	uint16_t own_addr = bt_mesh_model_elem(gus->model)->addr;
 
-	size_t len = strlen(name);
-	net_buf_simple_add_mem(&msg, name, len);
-	net_buf_simple_add_u8(&msg, '\0');
+	if (!gus->sign_in_len || gus->sign_in_addr != own_addr)
+	{
+		const char *name = gus_core_sign_in_name((const char *)gus->name,
+												 own_addr);
+		struct net_buf_simple buf;
+
+		net_buf_simple_init_with_data(&buf, gus->sign_in_reply,
+									  sizeof(gus->sign_in_reply));
+		net_buf_simple_reset(&buf);
+		bt_mesh_model_msg_init(&buf, BT_MESH_GUS_OP_SIGN_IN_REPLY);
+		net_buf_simple_add_mem(&buf, name,
+							   strnlen(name, CONFIG_BT_MESH_GUS_NAME_LENGTH));
+		net_buf_simple_add_u8(&buf, '\0');
+
+		gus->sign_in_len = buf.len;
+		gus->sign_in_addr = own_addr;
+	}
 
-	return bt_mesh_model_send(gus->model, ctx, &msg, NULL, NULL);
+	// the outbound queue copies the cached reply, which stays plain text
+	return gus_tx_send_data(gus->model, ctx, gus->sign_in_reply,
+							gus->sign_in_len, BT_MESH_GUS_OP_SIGN_IN_REPLY);
 }
 
 int bt_mesh_gus_svr_report_reply(struct bt_mesh_gus *gus,
@@ -258,20 +693,159 @@ int bt_mesh_gus_svr_report_reply(struct bt_mesh_gus *gus,
 							 BT_MESH_GUS_MSG_LEN_REPORT_REPLY);
 	bt_mesh_model_msg_init(&msg, BT_MESH_GUS_OP_REPORT_REPLY);
 
-	net_buf_simple_add_mem(&msg, report, BT_MESH_GUS_MSG_LEN_REPORT_REPLY);
+	// the report holds the entries only, the trailing byte is always 0
+	net_buf_simple_add_mem(&msg, report,
+						   NUM_PROXIMITY_REPORTS * sizeof(struct gus_report_data));
+	net_buf_simple_add_u8(&msg, 0);
+
+	return model_send(gus, ctx, &msg, BT_MESH_GUS_OP_REPORT_REPLY);
+}
+
+int bt_mesh_gus_svr_report_compact_reply(struct bt_mesh_gus *gus,
+										 struct bt_mesh_msg_ctx *ctx,
+										 const struct gus_report_data *report,
+										 size_t count)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, BT_MESH_GUS_OP_REPORT_COMPACT_REPLY,
+							 BT_MESH_GUS_MSG_MAXLEN_REPORT_COMPACT_REPLY);
+	bt_mesh_model_msg_init(&msg, BT_MESH_GUS_OP_REPORT_COMPACT_REPLY);
+
+	uint16_t own_addr = bt_mesh_model_elem(gus->model)->addr;
+	size_t len = gus_core_compact_encode(own_addr, report, count,
+										 net_buf_simple_tail(&msg));
+
+	net_buf_simple_add(&msg, len);
+
+	return model_send(gus, ctx, &msg, BT_MESH_GUS_OP_REPORT_COMPACT_REPLY);
+}
+
+int bt_mesh_gus_svr_exposure_reply(struct bt_mesh_gus *gus,
+								   struct bt_mesh_msg_ctx *ctx,
+								   uint8_t total, uint16_t after,
+								   const struct gus_exposure_data *exposure,
+								   size_t count)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, BT_MESH_GUS_OP_EXPOSURE_REPLY,
+							 BT_MESH_GUS_MSG_MAXLEN_EXPOSURE_REPLY);
+	bt_mesh_model_msg_init(&msg, BT_MESH_GUS_OP_EXPOSURE_REPLY);
+
+	count = MIN(count, BT_MESH_GUS_EXPOSURE_PAGE);
+
+	net_buf_simple_add_u8(&msg, total);
+	net_buf_simple_add_le16(&msg, after);
+	net_buf_simple_add_u8(&msg, count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		net_buf_simple_add_le16(&msg, exposure[i].addr);
+		for (int band = 0; band < BT_MESH_GUS_EXPOSURE_BANDS; ++band)
+		{
+			net_buf_simple_add_le16(&msg, exposure[i].seconds[band]);
+		}
+	}
+
+	return model_send(gus, ctx, &msg, BT_MESH_GUS_OP_EXPOSURE_REPLY);
+}
+
+int bt_mesh_gus_svr_log_reply(struct bt_mesh_gus *gus,
+							  struct bt_mesh_msg_ctx *ctx, uint32_t last,
+							  const struct gus_contact_record *records,
+							  size_t count)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, BT_MESH_GUS_OP_LOG_REPLY,
+							 BT_MESH_GUS_MSG_MAXLEN_LOG_REPLY);
+	bt_mesh_model_msg_init(&msg, BT_MESH_GUS_OP_LOG_REPLY);
+
+	count = MIN(count, BT_MESH_GUS_LOG_PAGE);
 
-	return bt_mesh_model_send(gus->model, ctx, &msg, NULL, NULL);
+	net_buf_simple_add_le32(&msg, last);
+	net_buf_simple_add_u8(&msg, count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		net_buf_simple_add_le32(&msg, records[i].seq);
+		net_buf_simple_add_le16(&msg, records[i].boot);
+		net_buf_simple_add_le32(&msg, records[i].time);
+		net_buf_simple_add_le16(&msg, records[i].addr);
+		net_buf_simple_add_u8(&msg, records[i].rssi);
+		net_buf_simple_add_u8(&msg, records[i].confidence);
+		for (int band = 0; band < BT_MESH_GUS_EXPOSURE_BANDS; ++band)
+		{
+			net_buf_simple_add_le16(&msg, records[i].seconds[band]);
+		}
+	}
+
+	return model_send(gus, ctx, &msg, BT_MESH_GUS_OP_LOG_REPLY);
+}
+
+void bt_mesh_gus_svr_state_set(struct bt_mesh_gus *gus,
+							   enum bt_mesh_gus_state state)
+{
+	set_state(gus, NULL, state);
 }
 
 int bt_mesh_gus_svr_check_proximity(struct bt_mesh_gus *gus)
 {
-	//todo	set_tx_power(BT_HCI_VS_LL_HANDLE_TYPE_ADV, 0, -8);
+	// never wait for the controller or the advertiser in the caller's
+	// thread, and never rewrite the publication message from two threads
+	return gus_tx_publish(beacon_send, gus, BT_MESH_GUS_OP_CHECK_PROXIMITY);
+}
 
-	struct net_buf_simple *buf = gus->model->pub->msg;
-	bt_mesh_model_msg_init(buf, BT_MESH_GUS_OP_CHECK_PROXIMITY);
+int bt_mesh_gus_svr_stats_reply(struct bt_mesh_gus *gus,
+								struct bt_mesh_msg_ctx *ctx, uint8_t op,
+								const struct gus_stats_op *stats)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, BT_MESH_GUS_OP_STATS_REPLY,
+							 BT_MESH_GUS_MSG_LEN_STATS_REPLY);
+	bt_mesh_model_msg_init(&msg, BT_MESH_GUS_OP_STATS_REPLY);
+
+	net_buf_simple_add_u8(&msg, op);
+	net_buf_simple_add_le32(&msg, stats->rx);
+	net_buf_simple_add_le32(&msg, stats->tx);
+	net_buf_simple_add_le32(&msg, stats->tx_err);
+	for (int i = 0; i < GUS_STATS_LATENCY_BINS; ++i)
+	{
+		net_buf_simple_add_le16(&msg, stats->latency[i]);
+	}
+
+	return model_send(gus, ctx, &msg, BT_MESH_GUS_OP_STATS_REPLY);
+}
+
+int bt_mesh_gus_svr_telemetry_reply(struct bt_mesh_gus *gus,
+									struct bt_mesh_msg_ctx *ctx,
+									const struct gus_energy *energy)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, BT_MESH_GUS_OP_TELEMETRY_REPLY,
+							 BT_MESH_GUS_MSG_LEN_TELEMETRY_REPLY);
+	bt_mesh_model_msg_init(&msg, BT_MESH_GUS_OP_TELEMETRY_REPLY);
+
+	net_buf_simple_add_le32(&msg, energy->uptime_s);
+	net_buf_simple_add_le32(&msg, energy->tx_count);
+	net_buf_simple_add_le32(&msg, energy->tx_ms);
+	net_buf_simple_add_le32(&msg, energy->scan_s);
+	net_buf_simple_add_le32(&msg, energy->led_ms);
+	net_buf_simple_add_le32(&msg, energy->charge_uah);
+
+	return model_send(gus, ctx, &msg, BT_MESH_GUS_OP_TELEMETRY_REPLY);
+}
+
+int bt_mesh_gus_svr_restore_early(struct bt_mesh_gus *gus, uint8_t elem_idx,
+								  uint8_t mod_idx)
+{
+#ifdef CONFIG_BT_SETTINGS
+	char path[20];
+	int err;
 
-	// set ttl no relays, only interested in direct connections.
-	gus->model->pub->ttl = 0;
-	gus->model->pub->send_rel = false;
-	return bt_mesh_model_publish(gus->model);
+	err = settings_subsys_init();
+	if (err)
+	{
+		return err;
+	}
+
+	// the key bt_mesh_model_data_store() uses for a vendor model
+	snprintk(path, sizeof(path), "bt/mesh/v/%x",
+			 (elem_idx << 8) | mod_idx);
+
+	return settings_load_subtree_direct(path, early_restore_cb, gus);
+#else
+	return -ENOTSUP;
+#endif
 }
@@ -23,14 +23,37 @@
 //       Client sends badge(2) request for report and the process repeats.
 //       All badges eventually get asked for a report and in the process create
 //                create new proximity reports.
+//    With CONFIG_GUS_SWEEP the badges send Check Proximity on their own, each
+//    in a time slot derived from its address (see gus_sweep.h), and the
+//    report request only collects the contacts.
+//    With CONFIG_GUS_SPREAD the message carries the state of the sender
+//    (1 byte), see gus_spread.h.
 //
 // Message handlers:
 // Sign-in - replys to the sign-in message providing the client
 //     with the badges name and address
 // Report request - reply to the report request sending the contact information
 //      for the most significant contacts.
+// Compact report request - same as the report request, but the reply only
+//      carries the valid contacts in a variable length encoding.
+// Exposure request - reply with the accumulated contact time per neighbor,
+//      one page of neighbors at a time.
+// Log get - reply with the records of the flash contact log that follow a
+//      given sequence number.
+// Status - published periodically with the state, a hash of the name and
+//      the neighbor counts, so a client can follow the room passively.
+// Set states - sent to a group, sets the state of every badge in a range of
+//      addresses with one message.
+// Stats get - reply with the message counters and handler latencies of one
+//      opcode (gus_stats.h).
+// Telemetry get - reply with the energy counters and the estimated charge
+//      consumed (gus_energy.h).
 // Check Proximity - Records the sending badge's address and the rssi value
 //      which is use to create a report for the report request message
+//
+// Replies and beacons go through the outbound queue (gus_tx.h), so the
+// reply functions return 0 once the message is queued and -ENOMEM when
+// the queue is full.  Send errors show in the queue and message counters.
 //////////////////////////////////////////////////////////////////////////////
 
 #ifndef BT_MESH_GUS_SVR_H__
@@ -38,14 +61,15 @@
 
 #include <bluetooth/mesh.h>
 #include <bluetooth/mesh/model_types.h>
+#include "gus_core.h"
+#include "gus_stats.h"
+#include "gus_energy.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define CONFIG_BT_MESH_GUS_NAME_LENGTH 12   // max length of a name
-#define NUM_PROXIMITY_REPORTS 6             // number of proximity records
-                                            // sent in a message
 
 /** Company ID of the Bluetooth Mesh Gus model. */
 #define BT_MESH_GUS_VENDOR_COMPANY_ID    0xFFFF  // not a real company
@@ -81,12 +105,58 @@ extern "C" {
 /** Check proximity opcode. */
 #define BT_MESH_GUS_OP_CHECK_PROXIMITY BT_MESH_MODEL_OP_3(0x0A, \
 				       BT_MESH_GUS_VENDOR_COMPANY_ID)
+/** Check proximity length, with the state of the sender. */
+#define BT_MESH_GUS_MSG_MAXLEN_CHECK_PROXIMITY 1
+
+/** Compact report opcode. */
+#define BT_MESH_GUS_OP_REPORT_COMPACT BT_MESH_MODEL_OP_3(0x0B, \
+				       BT_MESH_GUS_VENDOR_COMPANY_ID)
+
+/** Compact report reply opcode. */
+#define BT_MESH_GUS_OP_REPORT_COMPACT_REPLY BT_MESH_MODEL_OP_3(0x0C, \
+				       BT_MESH_GUS_VENDOR_COMPANY_ID)
+
+/** Exposure opcode. */
+#define BT_MESH_GUS_OP_EXPOSURE BT_MESH_MODEL_OP_3(0x0D, \
+				       BT_MESH_GUS_VENDOR_COMPANY_ID)
+
+/** Exposure reply opcode. */
+#define BT_MESH_GUS_OP_EXPOSURE_REPLY BT_MESH_MODEL_OP_3(0x0E, \
+				       BT_MESH_GUS_VENDOR_COMPANY_ID)
+
+/** Log get opcode. */
+#define BT_MESH_GUS_OP_LOG_GET BT_MESH_MODEL_OP_3(0x0F, \
+				       BT_MESH_GUS_VENDOR_COMPANY_ID)
+
+/** Log reply opcode. */
+#define BT_MESH_GUS_OP_LOG_REPLY BT_MESH_MODEL_OP_3(0x10, \
+				       BT_MESH_GUS_VENDOR_COMPANY_ID)
+
+/** Stats get opcode. */
+#define BT_MESH_GUS_OP_STATS_GET BT_MESH_MODEL_OP_3(0x11, \
+				       BT_MESH_GUS_VENDOR_COMPANY_ID)
+
+/** Stats reply opcode. */
+#define BT_MESH_GUS_OP_STATS_REPLY BT_MESH_MODEL_OP_3(0x12, \
+				       BT_MESH_GUS_VENDOR_COMPANY_ID)
+
+/** Telemetry get opcode. */
+#define BT_MESH_GUS_OP_TELEMETRY_GET BT_MESH_MODEL_OP_3(0x13, \
+				       BT_MESH_GUS_VENDOR_COMPANY_ID)
+
+/** Telemetry reply opcode. */
+#define BT_MESH_GUS_OP_TELEMETRY_REPLY BT_MESH_MODEL_OP_3(0x14, \
+				       BT_MESH_GUS_VENDOR_COMPANY_ID)
+
+/** Set states opcode. */
+#define BT_MESH_GUS_OP_SET_STATES BT_MESH_MODEL_OP_3(0x15, \
+				       BT_MESH_GUS_VENDOR_COMPANY_ID)
+
+/** Status opcode. */
+#define BT_MESH_GUS_OP_STATUS BT_MESH_MODEL_OP_3(0x16, \
+				       BT_MESH_GUS_VENDOR_COMPANY_ID)
 
 
-struct gus_report_data {
-    uint16_t addr;
-    int8_t rssi;
-    }; 
 
 
 #define BT_MESH_GUS_MSG_MINLEN_MESSAGE 1
@@ -98,6 +168,125 @@ struct gus_report_data {
 #define BT_MESH_GUS_MSG_LEN_REPORT_REPLY (NUM_PROXIMITY_REPORTS*sizeof(struct gus_report_data)+1)
 #define BT_MESH_GUS_MSG_LEN_REQUEST 0
 
+//////////////////////////////////////////////////////////////////////////////
+// Exposure request:  after (2 bytes, optional) address of the last
+//                                         neighbor the client has, 0 or
+//                                         left out for the first page
+// Exposure reply:    total (1 byte)  number of neighbors with contact time
+//                    after (2 bytes) address the page starts after
+//                    count (1 byte)  number of neighbors sent, followed by
+//                    count entries of
+//                      addr     (2 bytes) unicast address
+//                      seconds  (2 bytes) contact time at or above the
+//                                         near, mid and far rssi levels,
+//                                         BT_MESH_GUS_EXPOSURE_BANDS times
+// Entries are sent in address order, all fields little endian.  The
+// client asks for the next page with the address of the last entry until
+// a page has fewer than BT_MESH_GUS_EXPOSURE_PAGE entries, so neighbors
+// that come and go between requests are neither skipped nor repeated.
+//////////////////////////////////////////////////////////////////////////////
+#define BT_MESH_GUS_EXPOSURE_PAGE  8      // neighbors per reply
+#define BT_MESH_GUS_MSG_LEN_EXPOSURE_ENTRY (2 + 2 * BT_MESH_GUS_EXPOSURE_BANDS)
+#define BT_MESH_GUS_MSG_MAXLEN_EXPOSURE_REPLY (4 + BT_MESH_GUS_EXPOSURE_PAGE * \
+				BT_MESH_GUS_MSG_LEN_EXPOSURE_ENTRY)
+
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Log get:    after (4 bytes) sequence number of the last record the
+//                             client has, 0 for the start of the log
+//             count (1 byte)  number of records wanted
+// Log reply:  last  (4 bytes) sequence number of the newest stored record
+//             count (1 byte)  number of records sent, followed by count
+//                             records, all fields little endian
+// Records are sent in sequence order, the client asks again with the
+// sequence number of the last record received until it reaches last.
+//////////////////////////////////////////////////////////////////////////////
+#define BT_MESH_GUS_LOG_PAGE 4            // records per reply
+#define BT_MESH_GUS_MSG_LEN_LOG_GET 5
+#define BT_MESH_GUS_MSG_LEN_LOG_RECORD (14 + 2 * BT_MESH_GUS_EXPOSURE_BANDS)
+#define BT_MESH_GUS_MSG_MAXLEN_LOG_REPLY (5 + BT_MESH_GUS_LOG_PAGE * \
+				BT_MESH_GUS_MSG_LEN_LOG_RECORD)
+
+/** One contact of a proximity round, as stored in the contact log. */
+struct gus_contact_record {
+	uint32_t seq;          // sequence number, never reused
+	uint16_t boot;         // boot count of the badge
+	uint32_t time;         // uptime at the end of the round, seconds
+	uint16_t addr;
+	int8_t rssi;           // smoothed rssi
+	uint8_t confidence;    // enum bt_mesh_gus_confidence
+	uint16_t seconds[BT_MESH_GUS_EXPOSURE_BANDS]; // contact time since
+	                                              // the previous record
+} __packed;
+
+//////////////////////////////////////////////////////////////////////////////
+// Stats get:    op      (1 byte)  opcode number, e.g. 0x08 for Report
+// Stats reply:  op      (1 byte)  opcode number
+//               rx      (4 bytes) messages received
+//               tx      (4 bytes) messages sent or published
+//               tx_err  (4 bytes) failed sends and publishes
+//               latency (2 bytes) handler latency histogram bin,
+//                                 GUS_STATS_LATENCY_BINS times
+// All fields are little endian, see gus_stats.h for the bins.  Counters of
+// an opcode number out of range read as zero.
+//////////////////////////////////////////////////////////////////////////////
+#define BT_MESH_GUS_MSG_LEN_STATS_GET 1
+#define BT_MESH_GUS_MSG_LEN_STATS_REPLY (13 + 2 * GUS_STATS_LATENCY_BINS)
+
+//////////////////////////////////////////////////////////////////////////////
+// Telemetry get:    no parameters
+// Telemetry reply:  uptime  (4 bytes) seconds since boot
+//                   tx      (4 bytes) advertising events sent
+//                   tx_ms   (4 bytes) estimated radio transmit time
+//                   scan    (4 bytes) seconds spent scanning
+//                   led_ms  (4 bytes) LED-on time of one LED at full
+//                                     brightness
+//                   charge  (4 bytes) estimated charge consumed, uAh
+// All fields are little endian and count from boot, see gus_energy.h.
+//////////////////////////////////////////////////////////////////////////////
+#define BT_MESH_GUS_MSG_LEN_TELEMETRY_REPLY 24
+
+//////////////////////////////////////////////////////////////////////////////
+// Set states:  base    (2 bytes) unicast address of the first badge
+//              states  (4 bits)  enum bt_mesh_gus_state of badge base + i,
+//                                entry i in the low nibble of byte i / 2 for
+//                                even i and in the high nibble for odd i
+// Sent to a group, each badge looks up its own nibble at own address -
+// base.  A badge outside the list, or with the state
+// BT_MESH_GUS_STATE_UNCHANGED or any other value above BT_MESH_GUS_OFF,
+// keeps its state.  The full message takes 7 segments, receiving it needs
+// CONFIG_BT_MESH_RX_SEG_MAX of 7 or more.
+//////////////////////////////////////////////////////////////////////////////
+#define BT_MESH_GUS_STATE_UNCHANGED 0xf
+#define BT_MESH_GUS_SET_STATES_MAX 128    // badges per message
+#define BT_MESH_GUS_MSG_MINLEN_SET_STATES 3
+#define BT_MESH_GUS_MSG_MAXLEN_SET_STATES (2 + BT_MESH_GUS_SET_STATES_MAX / 2)
+
+//////////////////////////////////////////////////////////////////////////////
+// Status:  state      (1 byte)  enum bt_mesh_gus_state
+//          name_hash  (2 bytes) gus_core_name_hash() of the sign in name
+//          neighbors  (1 byte)  neighbors in the table
+//          contacts   (1 byte)  neighbors close enough to be reported
+//          ttl        (1 byte)  TTL the status was published with
+// Published periodically, with the period of the model publication set
+// by the configuration client.  A badge that receives the status of
+// another badge with its initial TTL heard it directly, and with
+// CONFIG_GUS_PASSIVE_PROXIMITY takes its rssi as a proximity sample.  The
+// Check Proximity beacons go to the same publish address, but as their own
+// message with TTL 0, outside the publication.
+//////////////////////////////////////////////////////////////////////////////
+#define BT_MESH_GUS_MSG_LEN_STATUS 6
+
+/** Status published by a badge. */
+struct bt_mesh_gus_status {
+	uint8_t state;
+	uint16_t name_hash;
+	uint8_t neighbors;
+	uint8_t contacts;
+	uint8_t ttl;
+};
 
 /** Bluetooth Mesh Gus state values. */
 enum bt_mesh_gus_state {
@@ -113,6 +302,9 @@ enum bt_mesh_gus_state {
         BT_MESH_GUS_OFF,
 };
 
+BUILD_ASSERT(BT_MESH_GUS_OFF < BT_MESH_GUS_STATE_UNCHANGED,
+	     "Every state must fit in a set states nibble.");
+
 /* Forward declaration of the Bluetooth Mesh Gus model context. */
 struct bt_mesh_gus;
 
@@ -139,6 +331,29 @@ struct bt_mesh_gus_handlers {
 	 */
 	void (*const start)(struct bt_mesh_gus *gus);
 
+	/** @brief Called when the node is reset and unprovisioned.
+	 *
+	 * @param[in] gus Gus Server instance that has been reset.
+	 */
+	void (*const reset)(struct bt_mesh_gus *gus);
+
+	/** @brief Called when the state and name have been restored from
+	 * persistent storage, before the mesh is started.
+	 *
+	 * @param[in] gus Gus Server instance that has been restored.
+	 */
+	void (*const restored)(struct bt_mesh_gus *gus);
+
+	/** @brief Called before a periodic status publication.
+	 *
+	 * The server fills in the state and name hash.
+	 *
+	 * @param[in] gus    Gus Server instance that publishes.
+	 * @param[out] status Status to fill in the neighbor counts of.
+	 */
+	void (*const status)(struct bt_mesh_gus *gus,
+			     struct bt_mesh_gus_status *status);
+
 	/** @brief Handler for a sign in message.
 	 *
 	 * @param[in] Gus Server instance that received the text message.
@@ -152,7 +367,8 @@ struct bt_mesh_gus_handlers {
 	/** @brief Handler for a set state message.
 	 *
 	 * @param[in] gus Server instance that received the text message.
-	 * @param[in] ctx Context of the incoming message.
+	 * @param[in] ctx Context of the incoming message, NULL when the badge
+	 *                changed its own state.
 	 * @param[in] state of a Gus Server
 	 * the message.
 	 */
@@ -179,6 +395,52 @@ struct bt_mesh_gus_handlers {
 	void (*const report_request)(struct bt_mesh_gus *gus,
 			       struct bt_mesh_msg_ctx *ctx);
 
+	/** @brief Handler for a compact report request.
+	 *
+	 * @param[in] Gus Server instance that received the text message.
+	 * @param[in] ctx Context of the incoming message.
+	 */
+	void (*const report_compact_request)(struct bt_mesh_gus *gus,
+			       struct bt_mesh_msg_ctx *ctx);
+
+	/** @brief Handler for an exposure request.
+	 *
+	 * @param[in] Gus Server instance that received the text message.
+	 * @param[in] ctx Context of the incoming message.
+	 * @param[in] after Address the requested page starts after.
+	 */
+	void (*const exposure_request)(struct bt_mesh_gus *gus,
+			       struct bt_mesh_msg_ctx *ctx,
+			       uint16_t after);
+
+	/** @brief Handler for a log get message.
+	 *
+	 * @param[in] Gus Server instance that received the text message.
+	 * @param[in] ctx Context of the incoming message.
+	 * @param[in] after Sequence number of the last record the client has.
+	 * @param[in] count Number of records requested.
+	 */
+	void (*const log_get)(struct bt_mesh_gus *gus,
+			       struct bt_mesh_msg_ctx *ctx,
+			       uint32_t after, uint8_t count);
+
+	/** @brief Handler for a stats get message.
+	 *
+	 * @param[in] Gus Server instance that received the text message.
+	 * @param[in] ctx Context of the incoming message.
+	 * @param[in] op Opcode number the statistics are requested for.
+	 */
+	void (*const stats_get)(struct bt_mesh_gus *gus,
+			       struct bt_mesh_msg_ctx *ctx, uint8_t op);
+
+	/** @brief Handler for a telemetry get message.
+	 *
+	 * @param[in] Gus Server instance that received the text message.
+	 * @param[in] ctx Context of the incoming message.
+	 */
+	void (*const telemetry_get)(struct bt_mesh_gus *gus,
+			       struct bt_mesh_msg_ctx *ctx);
+
 	/** @brief Handler for a reply on a report request.
 	 *
 	 * @param[in] Gus Server instance that received the reply.
@@ -189,15 +451,31 @@ struct bt_mesh_gus_handlers {
 				    struct bt_mesh_msg_ctx *ctx,
 				      const uint8_t *msg);
 
+	/** @brief Handler for passive proximity sampling.
+	 *
+	 * Called for the status publications other badges send straight to
+	 * this one, not through a relay, when CONFIG_GUS_PASSIVE_PROXIMITY is
+	 * enabled, so the rssi of the message can be used as a proximity
+	 * sample.  Requests of a client are never sampled, the collector is
+	 * not a contact.
+	 *
+	 * @param[in] Gus Server instance that received the message.
+	 * @param[in] ctx Context of the incoming message.
+	 */
+	void (*const overheard)(struct bt_mesh_gus *gus,
+			       struct bt_mesh_msg_ctx *ctx);
+
 	/** @brief Handler for a check proximity message.
 	 *
 	 * @param[in] Gus Server instance that received the text message.
 	 * @param[in] ctx Context of the incoming message.
 	 * @param[in] addr address of sender.
+	 * @param[in] state State of the sender, BT_MESH_GUS_STATE_UNCHANGED
+	 *                  if the beacon carries none.
 	 */
 	void (*const check_proximity)(struct bt_mesh_gus *gus,
 			       struct bt_mesh_msg_ctx *ctx,
-                               uint16_t addr);
+                               uint16_t addr, uint8_t state);
 
 
 };
@@ -221,29 +499,41 @@ struct bt_mesh_gus {
 	const struct bt_mesh_gus_handlers *handlers;
 	/** Current Presence value. */
 	enum bt_mesh_gus_state state;
+	/** Stores the state and name, once per CONFIG_GUS_STORE_DELAY_MS. */
+	struct k_work_delayable store_work;
+	/** Encoded sign in reply, opcode included. */
+	uint8_t sign_in_reply[BT_MESH_MODEL_BUF_LEN(BT_MESH_GUS_OP_SIGN_IN_REPLY,
+					BT_MESH_GUS_MSG_LEN_SIGN_IN_REPLY)];
+	/** Length of the sign in reply, 0 when it must be encoded again. */
+	uint8_t sign_in_len;
+	/** Address the sign in reply was encoded for. */
+	uint16_t sign_in_addr;
 };
 
 
 
-/** @brief Reply to the sign in request.
+/** @brief Reply to the sign in request with the badge name.
+ *
+ * The reply carries the name set by the client, or a spare name picked by
+ * the badge address.  It is encoded once and kept until the name or the
+ * address changes.
  *
- * @param[in] gus    Gus Server model instance to set presence on.
+ * @param[in] gus    Gus Server model instance.
  * @param[in] ctx    Context of the original message.
- * @param[in] name   Name associated with the badge.
  *
- * @retval 0 Successfully set the preceive and sent the message.
+ * @retval 0 Successfully sent the message.
  * @retval -EADDRNOTAVAIL Publishing is not configured.
  * @retval -EAGAIN The device has not been provisioned.
  */
-int bt_mesh_gus_svr_sign_in_reply(struct bt_mesh_gus *gus, 
-                                    struct bt_mesh_msg_ctx *ctx, 
-                                    const uint8_t * name);
+int bt_mesh_gus_svr_sign_in_reply_cached(struct bt_mesh_gus *gus,
+					 struct bt_mesh_msg_ctx *ctx);
 
 
 /** @brief Proximity report reply.
  *
  * @param[in] gus     Gus server model instance to sign into.
- * @param[in] report Pointer array of bytes containing report
+ * @param[in] report Pointer array of bytes containing report, the
+ *                   NUM_PROXIMITY_REPORTS entries without the trailing byte
  *
  * @retval 0 Successfully set the preceive and sent the message.
  * @retval -EADDRNOTAVAIL Publishing is not configured.
@@ -253,16 +543,133 @@ int bt_mesh_gus_svr_report_reply(struct bt_mesh_gus *gus,
 				  struct bt_mesh_msg_ctx *ctx, 
 				  const uint8_t *report);
 
-/** @brief Check Proximity.
+/** @brief Compact proximity report reply.
  *
- * @param[in] gus     Gus server model instance to sign into.
+ * Encodes the valid entries of @p report in the compact report format and
+ * sends them back to the requester.
  *
- * @retval 0 Successfully set the preceive and sent the message.
+ * @param[in] gus    Gus server model instance.
+ * @param[in] ctx    Context of the original message.
+ * @param[in] report Proximity entries, unused entries have address 0.
+ * @param[in] count  Number of entries in @p report.
+ *
+ * @retval 0 Successfully sent the message.
+ * @retval -EADDRNOTAVAIL Publishing is not configured.
+ * @retval -EAGAIN The device has not been provisioned.
+ */
+int bt_mesh_gus_svr_report_compact_reply(struct bt_mesh_gus *gus,
+				  struct bt_mesh_msg_ctx *ctx,
+				  const struct gus_report_data *report,
+				  size_t count);
+
+/** @brief Exposure reply.
+ *
+ * @param[in] gus      Gus server model instance.
+ * @param[in] ctx      Context of the original message.
+ * @param[in] total    Number of neighbors with contact time.
+ * @param[in] after    Address the page starts after.
+ * @param[in] exposure Contact times to send.
+ * @param[in] count    Number of entries in @p exposure, at most
+ *                     BT_MESH_GUS_EXPOSURE_PAGE.
+ *
+ * @retval 0 Successfully sent the message.
+ * @retval -EADDRNOTAVAIL Publishing is not configured.
+ * @retval -EAGAIN The device has not been provisioned.
+ */
+int bt_mesh_gus_svr_exposure_reply(struct bt_mesh_gus *gus,
+				   struct bt_mesh_msg_ctx *ctx,
+				   uint8_t total, uint16_t after,
+				   const struct gus_exposure_data *exposure,
+				   size_t count);
+
+/** @brief Contact log reply.
+ *
+ * @param[in] gus     Gus server model instance.
+ * @param[in] ctx     Context of the original message.
+ * @param[in] last    Sequence number of the newest stored record.
+ * @param[in] records Records to send.
+ * @param[in] count   Number of records, at most BT_MESH_GUS_LOG_PAGE.
+ *
+ * @retval 0 Successfully sent the message.
+ * @retval -EADDRNOTAVAIL Publishing is not configured.
+ * @retval -EAGAIN The device has not been provisioned.
+ */
+int bt_mesh_gus_svr_log_reply(struct bt_mesh_gus *gus,
+			      struct bt_mesh_msg_ctx *ctx, uint32_t last,
+			      const struct gus_contact_record *records,
+			      size_t count);
+
+/** @brief Stats reply.
+ *
+ * @param[in] gus   Gus server model instance.
+ * @param[in] ctx   Context of the original message.
+ * @param[in] op    Opcode number of the statistics.
+ * @param[in] stats Statistics of the opcode.
+ *
+ * @retval 0 Successfully sent the message.
+ * @retval -EADDRNOTAVAIL Publishing is not configured.
+ * @retval -EAGAIN The device has not been provisioned.
+ */
+int bt_mesh_gus_svr_stats_reply(struct bt_mesh_gus *gus,
+				struct bt_mesh_msg_ctx *ctx, uint8_t op,
+				const struct gus_stats_op *stats);
+
+/** @brief Restore the state and name before the mesh is initialized.
+ *
+ * Reads the record the server stores, straight from the settings, and
+ * calls the restored handler.  The mesh restores it again when its
+ * settings are loaded.
+ *
+ * @param[in] gus      Gus server model instance.
+ * @param[in] elem_idx Index of the element holding the server.
+ * @param[in] mod_idx  Index of the server among the vendor models of the
+ *                     element.
+ *
+ * @retval 0 Success, also when nothing was stored.
+ * @retval -ENOTSUP Settings are disabled.
+ */
+int bt_mesh_gus_svr_restore_early(struct bt_mesh_gus *gus, uint8_t elem_idx,
+								  uint8_t mod_idx);
+
+/** @brief Telemetry reply.
+ *
+ * @param[in] gus    Gus server model instance.
+ * @param[in] ctx    Context of the original message.
+ * @param[in] energy Energy counters of the badge.
+ *
+ * @retval 0 Successfully sent the message.
  * @retval -EADDRNOTAVAIL Publishing is not configured.
  * @retval -EAGAIN The device has not been provisioned.
  */
+int bt_mesh_gus_svr_telemetry_reply(struct bt_mesh_gus *gus,
+				    struct bt_mesh_msg_ctx *ctx,
+				    const struct gus_energy *energy);
+
+/** @brief Check Proximity.
+ *
+ * The beacon is queued and sent from the system work queue to the publish
+ * address of the model, with TTL 0 so only badges in range hear it, and
+ * with CONFIG_GUS_BEACON_TX_POWER_CTRL after the TX power has been
+ * lowered.  Sending errors are not reported back, see gus_tx.h.
+ *
+ * @param[in] gus     Gus server model instance to sign into.
+ *
+ * @retval 0 The beacon is queued.
+ * @retval -ENOMEM The outbound queue is full.
+ */
 int bt_mesh_gus_svr_check_proximity(struct bt_mesh_gus *gus);
 
+/** @brief Change the state of the badge itself.
+ *
+ * Takes the same path as a received set state message, the set_state
+ * handler is called with a NULL context.
+ *
+ * @param[in] gus   Gus server model instance.
+ * @param[in] state New state.
+ */
+void bt_mesh_gus_svr_state_set(struct bt_mesh_gus *gus,
+			       enum bt_mesh_gus_state state);
+
 /** @cond INTERNAL_HIDDEN */
 extern const struct bt_mesh_model_op _bt_mesh_gus_svr_op[];
 extern const struct bt_mesh_model_cb _bt_mesh_gus_svr_cb;
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <random/rand32.h>
+#include <bluetooth/mesh.h>
+#include "gus_sweep.h"
+
+#ifdef CONFIG_GUS_SWEEP
+
+#define SWEEP_SLOTS (CONFIG_GUS_SWEEP_PERIOD_MS / CONFIG_GUS_SWEEP_SLOT_MS)
+// periods without hearing the reference badge before running on our own
+#define SWEEP_SYNC_LOST 3
+
+BUILD_ASSERT(SWEEP_SLOTS > 0, "The sweep period must hold at least one slot");
+BUILD_ASSERT(CONFIG_GUS_SWEEP_JITTER_MS + (CONFIG_GUS_SWEEP_BURST - 1) *
+	     CONFIG_GUS_SWEEP_BURST_INTERVAL_MS < CONFIG_GUS_SWEEP_SLOT_MS,
+	     "The jitter and the burst must stay inside the slot");
+
+static struct bt_mesh_gus *sweep_gus;
+static gus_sweep_round_cb sweep_round_end;
+static void sweep_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(sweep_work, sweep_handler);
+static int64_t period_start;
+static uint16_t sync_addr;
+static uint8_t burst_left;
+static int64_t sync_time;
+
+/////////////////////
+// Static functions
+/////////////////////
+
+static uint16_t own_addr(void)
+{
+	return bt_mesh_model_elem(sweep_gus->model)->addr;
+}
+
+// offset of the slot of a badge from the start of the period
+static uint32_t slot_offset(uint16_t addr)
+{
+	return (addr % SWEEP_SLOTS) * CONFIG_GUS_SWEEP_SLOT_MS;
+}
+
+static void schedule_next(void)
+{
+	uint32_t jitter = 0;
+	int64_t delay;
+
+	if (CONFIG_GUS_SWEEP_JITTER_MS > 0) {
+		jitter = sys_rand32_get() % CONFIG_GUS_SWEEP_JITTER_MS;
+	}
+
+	delay = period_start + slot_offset(own_addr()) + jitter -
+		k_uptime_get();
+	while (delay <= 0) {
+		period_start += CONFIG_GUS_SWEEP_PERIOD_MS;
+		delay += CONFIG_GUS_SWEEP_PERIOD_MS;
+	}
+
+	k_work_reschedule(&sweep_work, K_MSEC(delay));
+}
+
+static void sweep_handler(struct k_work *work)
+{
+	if (!sweep_gus) {
+		return;
+	}
+
+	(void)bt_mesh_gus_svr_check_proximity(sweep_gus);
+	if (--burst_left > 0) {
+		k_work_reschedule(&sweep_work,
+				  K_MSEC(CONFIG_GUS_SWEEP_BURST_INTERVAL_MS));
+		return;
+	}
+
+	if (sweep_round_end) {
+		sweep_round_end();
+	}
+
+	if (k_uptime_get() - sync_time >
+	    SWEEP_SYNC_LOST * CONFIG_GUS_SWEEP_PERIOD_MS) {
+		sync_addr = own_addr();
+	}
+
+	period_start += CONFIG_GUS_SWEEP_PERIOD_MS;
+	burst_left = CONFIG_GUS_SWEEP_BURST;
+	schedule_next();
+}
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+void gus_sweep_start(struct bt_mesh_gus *gus, gus_sweep_round_cb round_end)
+{
+	sweep_gus = gus;
+	sweep_round_end = round_end;
+	sync_addr = own_addr();
+	period_start = k_uptime_get();
+	burst_left = CONFIG_GUS_SWEEP_BURST;
+
+	schedule_next();
+}
+
+void gus_sweep_stop(void)
+{
+	if (sweep_gus) {
+		k_work_cancel_delayable(&sweep_work);
+		sweep_gus = NULL;
+	}
+}
+
+bool gus_sweep_is_running(void)
+{
+	return sweep_gus != NULL;
+}
+
+void gus_sweep_sync(uint16_t src)
+{
+	// follow the lowest address heard, it is the reference of the room
+	if (!sweep_gus || src > sync_addr) {
+		return;
+	}
+
+	sync_addr = src;
+	sync_time = k_uptime_get();
+	period_start = k_uptime_get() - slot_offset(src) -
+		       CONFIG_GUS_SWEEP_JITTER_MS / 2;
+
+	// a running burst finishes first, the next slot uses the new period
+	if (burst_left < CONFIG_GUS_SWEEP_BURST) {
+		return;
+	}
+
+	schedule_next();
+}
+
+#else
+
+void gus_sweep_start(struct bt_mesh_gus *gus, gus_sweep_round_cb round_end)
+{
+}
+
+void gus_sweep_stop(void)
+{
+}
+
+bool gus_sweep_is_running(void)
+{
+	return false;
+}
+
+void gus_sweep_sync(uint16_t src)
+{
+}
+
+#endif /* CONFIG_GUS_SWEEP */
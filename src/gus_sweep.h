@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus autonomous proximity sweep
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// Autonomous proximity sweep.
+//
+// Instead of waiting for the client to request a report (which is what
+// triggers the Check Proximity beacon in the polled mode), every badge
+// publishes its beacon once per sweep period in its own time slot:
+//
+//    slot   = unicast address % (period / slot length)
+//    offset = slot * slot length + random jitter
+//
+// Badges do not share a clock, so the first badge with a lower address
+// that is heard becomes the time reference, and the period is realigned to
+// that badge's slot.  Badges in radio range of each other then end up
+// beaconing in distinct slots and a full sweep takes one period no matter
+// how many badges are in the room.
+//
+// A slot can hold a short burst of beacons (CONFIG_GUS_SWEEP_BURST), so a
+// Low Power Node that only wakes up for its slot is still heard reliably.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GUS_SWEEP_H__
+#define GUS_SWEEP_H__
+
+#include <stdbool.h>
+#include "gus_svr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Callback at the end of each sweep period. */
+typedef void (*gus_sweep_round_cb)(void);
+
+/** @brief Start sending a beacon in this badge's slot every sweep period.
+ *
+ *  @param gus       Gus Server model instance used to publish the beacons.
+ *  @param round_end Called after each beacon, ends the proximity round.
+ */
+void gus_sweep_start(struct bt_mesh_gus *gus, gus_sweep_round_cb round_end);
+
+/** @brief Stop the autonomous sweep. */
+void gus_sweep_stop(void);
+
+/** @brief Check if the autonomous sweep is running.
+ *
+ *  @retval true The badge beacons on its own schedule.
+ */
+bool gus_sweep_is_running(void);
+
+/** @brief Realign the sweep period to a received beacon.
+ *
+ *  A burst that is already running is not cut short, the new period
+ *  applies from the next slot.
+ *
+ *  @param src Unicast address of the badge that sent the beacon.
+ */
+void gus_sweep_sync(uint16_t src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_SWEEP_H__ */
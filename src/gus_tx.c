@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <sys/slist.h>
+#include "gus_tx.h"
+#include "gus_stats.h"
+#include "gus_energy.h"
+
+#define MIC_LEN 4     // room bt_mesh_model_send() needs after the message
+
+struct tx_entry {
+	sys_snode_t node;
+	struct bt_mesh_model *model;          // NULL for a publication
+	int (*publish)(void *arg);
+	void *arg;
+	struct bt_mesh_msg_ctx ctx;
+	uint32_t op;
+	uint8_t attempts;
+	uint8_t len;
+	uint8_t data[CONFIG_GUS_TX_BUF_SIZE];
+};
+
+K_MEM_SLAB_DEFINE(pool, sizeof(struct tx_entry), CONFIG_GUS_TX_QUEUE, 4);
+
+static sys_slist_t queue = SYS_SLIST_STATIC_INIT(&queue);
+static uint8_t in_flight;
+static struct gus_tx_stats stats;
+static struct k_spinlock lock;
+
+static void tx_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(tx_work, tx_work_handler);
+
+// counts the message once, when its fate is known, and frees the entry
+static void release(struct tx_entry *entry, int err)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	stats.depth--;
+	k_spin_unlock(&lock, key);
+
+	gus_stats_tx(entry->op, err);
+	if (!err && entry->model) {
+		gus_energy_tx(entry->len);
+	}
+
+	k_mem_slab_free(&pool, (void **)&entry);
+}
+
+static void send_end(int err, void *cb_data)
+{
+	struct tx_entry *entry = cb_data;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	in_flight--;
+	if (err) {
+		stats.send_err++;
+	} else {
+		stats.sent++;
+	}
+	k_spin_unlock(&lock, key);
+
+	release(entry, err);
+	// keeps a pending backoff, unlike k_work_reschedule
+	k_work_schedule(&tx_work, K_NO_WAIT);
+}
+
+static const struct bt_mesh_send_cb send_cb = {
+	.end = send_end,
+};
+
+static int transmit(struct tx_entry *entry)
+{
+	if (!entry->model) {
+		return entry->publish(entry->arg);
+	}
+
+	// the mesh encrypts the message in place, so every attempt sends a
+	// fresh copy and a retry after -ENOBUFS starts from the plain text
+	NET_BUF_SIMPLE_DEFINE(msg, CONFIG_GUS_TX_BUF_SIZE);
+
+	net_buf_simple_add_mem(&msg, entry->data, entry->len);
+
+	return bt_mesh_model_send(entry->model, &entry->ctx, &msg, &send_cb,
+				  entry);
+}
+
+static bool retryable(int err)
+{
+	return err == -ENOBUFS || err == -EBUSY;
+}
+
+// sends the head of the queue while there is room in flight, only ever
+// run from the system work queue
+static void tx_work_handler(struct k_work *work)
+{
+	while (true) {
+		k_spinlock_key_t key = k_spin_lock(&lock);
+		struct tx_entry *entry;
+		sys_snode_t *node;
+		bool is_pub;
+		int err;
+
+		if (in_flight >= CONFIG_GUS_TX_INFLIGHT) {
+			k_spin_unlock(&lock, key);
+			return;
+		}
+
+		// off the queue before the send, its end callback may free it
+		// before bt_mesh_model_send() returns
+		node = sys_slist_get(&queue);
+		if (!node) {
+			k_spin_unlock(&lock, key);
+			return;
+		}
+
+		entry = CONTAINER_OF(node, struct tx_entry, node);
+		// a send that went out may be freed by its end callback before
+		// transmit() returns, so the entry is only read again on error
+		is_pub = !entry->model;
+		if (!is_pub) {
+			in_flight++;
+		}
+		k_spin_unlock(&lock, key);
+
+		err = transmit(entry);
+
+		key = k_spin_lock(&lock);
+		if (err && !is_pub) {
+			in_flight--;
+		}
+
+		if (retryable(err) && entry->attempts < CONFIG_GUS_TX_RETRIES) {
+			uint32_t backoff = CONFIG_GUS_TX_BACKOFF_MS << entry->attempts;
+
+			// back to the head, the order of the replies is kept
+			sys_slist_prepend(&queue, &entry->node);
+			entry->attempts++;
+			stats.retries++;
+			k_spin_unlock(&lock, key);
+
+			k_work_reschedule(&tx_work, K_MSEC(backoff));
+			return;
+		}
+
+		if (retryable(err)) {
+			stats.dropped++;
+		} else if (err) {
+			stats.send_err++;
+		} else if (is_pub) {
+			stats.sent++;
+		}
+		k_spin_unlock(&lock, key);
+
+		// a send that went out is released by its end callback
+		if (err || is_pub) {
+			release(entry, err);
+		}
+	}
+}
+
+static int enqueue(struct tx_entry *entry)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	sys_slist_append(&queue, &entry->node);
+	stats.queued++;
+	stats.depth++;
+	stats.max_depth = MAX(stats.max_depth, stats.depth);
+	k_spin_unlock(&lock, key);
+
+	// keeps a pending backoff, the new entry waits behind the retry
+	k_work_schedule(&tx_work, K_NO_WAIT);
+	return 0;
+}
+
+static struct tx_entry *alloc(uint32_t op)
+{
+	struct tx_entry *entry;
+
+	if (k_mem_slab_alloc(&pool, (void **)&entry, K_NO_WAIT)) {
+		k_spinlock_key_t key = k_spin_lock(&lock);
+
+		stats.dropped++;
+		k_spin_unlock(&lock, key);
+
+		gus_stats_tx(op, -ENOMEM);
+		return NULL;
+	}
+
+	memset(entry, 0, offsetof(struct tx_entry, data));
+	entry->op = op;
+	return entry;
+}
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+int gus_tx_send(struct bt_mesh_model *model, const struct bt_mesh_msg_ctx *ctx,
+		const struct net_buf_simple *msg, uint32_t op)
+{
+	return gus_tx_send_data(model, ctx, msg->data, msg->len, op);
+}
+
+int gus_tx_send_data(struct bt_mesh_model *model,
+		     const struct bt_mesh_msg_ctx *ctx, const uint8_t *data,
+		     size_t len, uint32_t op)
+{
+	struct tx_entry *entry;
+
+	if (len + MIC_LEN > CONFIG_GUS_TX_BUF_SIZE) {
+		gus_stats_tx(op, -EMSGSIZE);
+		return -EMSGSIZE;
+	}
+
+	entry = alloc(op);
+	if (!entry) {
+		return -ENOMEM;
+	}
+
+	entry->model = model;
+	entry->ctx = *ctx;
+	entry->len = len;
+	memcpy(entry->data, data, len);
+
+	return enqueue(entry);
+}
+
+int gus_tx_publish(int (*publish)(void *arg), void *arg, uint32_t op)
+{
+	struct tx_entry *entry = alloc(op);
+
+	if (!entry) {
+		return -ENOMEM;
+	}
+
+	entry->publish = publish;
+	entry->arg = arg;
+
+	return enqueue(entry);
+}
+
+void gus_tx_stats_get(struct gus_tx_stats *out)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	*out = stats;
+	k_spin_unlock(&lock, key);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file
+ * @brief Gus outbound message queue
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// Outbound queue - every Gus reply and beacon goes through here.
+//
+// A message is copied into one of CONFIG_GUS_TX_QUEUE pool entries and
+// sent from the system work queue, in order.  At most CONFIG_GUS_TX_INFLIGHT
+// sends are handed to the mesh at a time: the send end callback frees the
+// entry and starts the next one, so a burst of replies does not exhaust
+// the advertising buffers.  When the mesh still runs out of buffers
+// (-ENOBUFS) or segmentation contexts (-EBUSY), the head of the queue is
+// tried again after a doubling backoff, up to CONFIG_GUS_TX_RETRIES times.
+//
+// The Check Proximity beacon is queued as a function that sends it, because
+// it must lower the TX power right before it goes to the mesh.  Such an
+// entry is done once the function returns; the function keeps track of its
+// own send callbacks.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GUS_TX_H__
+#define GUS_TX_H__
+
+#include <bluetooth/mesh.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Outbound queue counters since boot. */
+struct gus_tx_stats {
+	uint32_t queued;       // messages accepted
+	uint32_t sent;         // messages the mesh finished sending
+	uint32_t retries;      // attempts repeated after -ENOBUFS or -EBUSY
+	uint32_t dropped;      // pool full, or out of retries
+	uint32_t send_err;     // other send errors, or failed in the mesh
+	uint8_t depth;         // messages queued or in flight right now
+	uint8_t max_depth;     // highest depth seen
+};
+
+/** @brief Queue a message for bt_mesh_model_send().
+ *
+ * @param model Model to send from.
+ * @param ctx   Message context, copied.
+ * @param msg   Message, opcode included, copied.
+ * @param op    Opcode, for the message statistics.
+ *
+ * @retval 0         The message is queued.
+ * @retval -EMSGSIZE The message does not fit in CONFIG_GUS_TX_BUF_SIZE.
+ * @retval -ENOMEM   The queue is full, the message is dropped.
+ */
+int gus_tx_send(struct bt_mesh_model *model, const struct bt_mesh_msg_ctx *ctx,
+		const struct net_buf_simple *msg, uint32_t op);
+
+/** @brief Queue an encoded message for bt_mesh_model_send().
+ *
+ * Same as gus_tx_send(), for a message kept encoded by the caller, which
+ * is copied straight into the queue entry.
+ *
+ * @param model Model to send from.
+ * @param ctx   Message context, copied.
+ * @param data  Message, opcode included, copied.
+ * @param len   Length of @p data.
+ * @param op    Opcode, for the message statistics.
+ *
+ * @retval 0         The message is queued.
+ * @retval -EMSGSIZE The message does not fit in CONFIG_GUS_TX_BUF_SIZE.
+ * @retval -ENOMEM   The queue is full, the message is dropped.
+ */
+int gus_tx_send_data(struct bt_mesh_model *model,
+		     const struct bt_mesh_msg_ctx *ctx, const uint8_t *data,
+		     size_t len, uint32_t op);
+
+/** @brief Queue a publication.
+ *
+ * @param publish Function that encodes and publishes the message, called
+ *                from the system work queue.  It is called again after a
+ *                backoff if it returns -ENOBUFS or -EBUSY.
+ * @param arg     Argument passed to @p publish.
+ * @param op      Opcode, for the message statistics.
+ *
+ * @retval 0       The publication is queued.
+ * @retval -ENOMEM The queue is full, the publication is dropped.
+ */
+int gus_tx_publish(int (*publish)(void *arg), void *arg, uint32_t op);
+
+/** @brief Get the queue counters.
+ *
+ * @param[out] stats Counters.
+ */
+void gus_tx_stats_get(struct gus_tx_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GUS_TX_H__ */
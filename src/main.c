@@ -14,6 +14,9 @@
 #include "gus_model_handler.h"
 #include "tx_power.h"
 #include "gus_leds.h"
+#include "gus_led_engine.h"
+#include "gus_boot.h"
+#include "bsim/gus_bsim.h"
 #include <bluetooth/hci_vs.h>
 
 static void bt_ready(int err)
@@ -25,11 +28,15 @@ static void bt_ready(int err)
     }
 
     printk("Bluetooth initialized\n");
+    gus_boot_mark(GUS_BOOT_BT);
 
-    gus_leds_init();
+#ifdef CONFIG_BOARD_NRF52_BSIM
+    err = bt_mesh_init(gus_bsim_prov_init(), gus_model_handler_init());
+#else
     dk_buttons_init(NULL);
 
     err = bt_mesh_init(bt_mesh_dk_prov_init(), gus_model_handler_init());
+#endif
     if (err)
     {
         printk("Initializing mesh failed (err %d)\n", err);
@@ -41,9 +48,14 @@ static void bt_ready(int err)
 
         settings_load();
     }
+    gus_boot_mark(GUS_BOOT_MESH);
 
+#ifdef CONFIG_BOARD_NRF52_BSIM
+    gus_bsim_start();
+#else
     /* This will be a no-op if settings_load() loaded provisioning info */
     bt_mesh_prov_enable(BT_MESH_PROV_ADV | BT_MESH_PROV_GATT);
+#endif
 
     printk("Mesh initialized\n");
 }
@@ -54,20 +66,25 @@ void main(void)
 
     printk("Initializing....\n");
 
+    // bring up the LEDs and show the stored health state first, the
+    // Bluetooth and mesh init with settings_load take a while
+    gus_leds_init();
+    gus_led_engine_init();
+    gus_boot_mark(GUS_BOOT_LEDS);
+
+    if (IS_ENABLED(CONFIG_SETTINGS))
+    {
+        gus_model_handler_restore_early();
+    }
+    // a fresh badge has no stored state, it is as restored as it gets
+    gus_boot_mark(GUS_BOOT_STATE);
+
     err = bt_enable(bt_ready);
     if (err)
     {
         printk("Bluetooth init failed (err %d)\n", err);
     }
 
-    while (1)
-    {
-        // manage blinking of LEDs in idle loop
-        k_sleep(K_MSEC(100));
-        if (get_blinker() >= 0)
-        {
-            uint16_t ledbit = dec_blinker() % 6;
-            gus_set_leds(0x01 << ledbit);
-        }
-    }
+    // nothing left to do here, the LED engine and the mesh run from
+    // work items and the Bluetooth threads
 }
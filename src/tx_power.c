@@ -5,62 +5,217 @@
  */
 
 /////////////////////////////////////////////////////////////////////////
-// This code was copied from the zephyr HCI example.
-// It is currently not being used.  Changing power levels seems to work
-// for everything except mesh communication.
-// The goal was to reduce the power levels for the poximity checking
-// operation to improve the ability to determine the distance between 
-// nodes, however the default power levels seem sufficient to demo
-// a proof of concept.
+// TX power manager.
+// Proximity beacons are sent at a reduced TX power, so the rssi falls off
+// faster with distance and separates near from far badges more sharply.
+// All other mesh traffic keeps the normal power.
+//
+// The power is changed with the vendor specific HCI command.  Commands are
+// queued and sent from the system work queue with bt_hci_cmd_send(), which
+// does not wait for the response, so neither the Bluetooth receive thread
+// nor the caller ever blocks on the controller.  HCI commands are handled
+// in order.  The beacon power is not queued: tx_power_beacon_begin() is
+// called from the system work queue right before the beacon is published,
+// and hands the command (after any still queued) to the HCI command queue
+// itself, so it reaches the controller ahead of the beacon's advertising.
 /////////////////////////////////////////////////////////////////////////
 
+#include <zephyr.h>
+#include <logging/log.h>
 #include <bluetooth/bluetooth.h>
-#include <bluetooth/mesh/models.h>
-#include <bluetooth/mesh/dk_prov.h>
-#include <dk_buttons_and_leds.h>
-#include "gus_model_handler.h"
-
 #include <bluetooth/hci.h>
 #include <bluetooth/hci_vs.h>
-
-#include <bluetooth/conn.h>
-#include <bluetooth/uuid.h>
-#include <bluetooth/gatt.h>
+#include <settings/settings.h>
 #include <sys/byteorder.h>
+#include <string.h>
+#include "tx_power.h"
+
+LOG_MODULE_DECLARE(gus);
+
+#define TX_QUEUE_LEN 4
+// retry of a restore that found no free HCI command buffer
+#define RESTORE_RETRY K_MSEC(10)
+
+struct tx_power_cmd {
+	uint8_t handle_type;
+	uint16_t handle;
+	int8_t level;
+};
 
-//static const int8_t txp[] = {4, 0, -3, -8, -15, -18, -23, -30};
+K_MSGQ_DEFINE(tx_queue, sizeof(struct tx_power_cmd), TX_QUEUE_LEN, 4);
 
-void set_tx_power(uint8_t handle_type, uint16_t handle, int8_t tx_pwr_lvl)
+static void tx_work_handler(struct k_work *work);
+static void restore_handler(struct k_work *work);
+
+static K_WORK_DEFINE(tx_work, tx_work_handler);
+static K_WORK_DELAYABLE_DEFINE(restore_work, restore_handler);
+static int8_t calibration;
+// beacons handed to the mesh and not sent yet
+static atomic_t beacons;
+
+/////////////////////
+// Static functions
+/////////////////////
+
+// hands one command to the HCI command queue, without waiting for it
+static int send_cmd(const struct tx_power_cmd *cmd)
 {
 	struct bt_hci_cp_vs_write_tx_power_level *cp;
-	struct bt_hci_rp_vs_write_tx_power_level *rp;
-	struct net_buf *buf, *rsp = NULL;
+	struct net_buf *buf;
 	int err;
 
 	buf = bt_hci_cmd_create(BT_HCI_OP_VS_WRITE_TX_POWER_LEVEL,
 				sizeof(*cp));
 	if (!buf) {
-		printk("Unable to allocate command buffer\n");
-		return;
+		LOG_WRN("Unable to allocate command buffer");
+		return -ENOBUFS;
 	}
 
 	cp = net_buf_add(buf, sizeof(*cp));
-	cp->handle = sys_cpu_to_le16(handle);
-	cp->handle_type = handle_type;
-	cp->tx_power_level = tx_pwr_lvl;
+	cp->handle = sys_cpu_to_le16(cmd->handle);
+	cp->handle_type = cmd->handle_type;
+	cp->tx_power_level = cmd->level;
+
+	err = bt_hci_cmd_send(BT_HCI_OP_VS_WRITE_TX_POWER_LEVEL, buf);
+	if (err) {
+		LOG_ERR("Set Tx power err: %d", err);
+	}
+
+	return err;
+}
+
+// only the system work queue takes commands off the queue
+static int flush_queue(void)
+{
+	struct tx_power_cmd cmd;
+
+	while (!k_msgq_peek(&tx_queue, &cmd)) {
+		int err = send_cmd(&cmd);
+
+		if (err == -ENOBUFS) {
+			// stays at the head, the next flush sends it
+			return err;
+		}
 
-	err = bt_hci_cmd_send_sync(BT_HCI_OP_VS_WRITE_TX_POWER_LEVEL,
-				   buf, &rsp);
+		(void)k_msgq_get(&tx_queue, &cmd, K_NO_WAIT);
+	}
+
+	return 0;
+}
+
+static void tx_work_handler(struct k_work *work)
+{
+	(void)flush_queue();
+}
+
+static int set_adv_power(int8_t level)
+{
+	struct tx_power_cmd cmd = {
+		.handle_type = BT_HCI_VS_LL_HANDLE_TYPE_ADV,
+		.handle = 0,
+		.level = level,
+	};
+
+	int err;
+
+	// an older queued change must not overtake this one
+	err = flush_queue();
 	if (err) {
-		uint8_t reason = rsp ?
-			((struct bt_hci_rp_vs_write_tx_power_level *)
-			  rsp->data)->status : 0;
-		printk("Set Tx power err: %d reason 0x%02x\n", err, reason);
+		return err;
+	}
+
+	return send_cmd(&cmd);
+}
+
+static void restore_handler(struct k_work *work)
+{
+	if (set_adv_power(CONFIG_GUS_MESH_TX_POWER) == -ENOBUFS) {
+		k_work_reschedule(&restore_work, RESTORE_RETRY);
+	}
+}
+
+#ifdef CONFIG_SETTINGS
+static int tx_power_settings_set(const char *key, size_t len,
+				 settings_read_cb read_cb, void *cb_arg)
+{
+	if (strcmp(key, "cal") || len != sizeof(calibration)) {
+		return -ENOENT;
+	}
+
+	ssize_t bytes = read_cb(cb_arg, &calibration, sizeof(calibration));
+
+	return bytes < 0 ? bytes : 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(gus_tx, "gus/tx", NULL, tx_power_settings_set,
+			       NULL, NULL);
+#endif
+
+/////////////////////////////
+// public access functions
+/////////////////////////////
+
+int set_tx_power(uint8_t handle_type, uint16_t handle, int8_t tx_pwr_lvl)
+{
+	struct tx_power_cmd cmd = {
+		.handle_type = handle_type,
+		.handle = handle,
+		.level = tx_pwr_lvl,
+	};
+	int err;
+
+	err = k_msgq_put(&tx_queue, &cmd, K_NO_WAIT);
+	if (err) {
+		return -ENOMEM;
+	}
+
+	k_work_submit(&tx_work);
+
+	return 0;
+}
+
+int tx_power_beacon_begin(void)
+{
+	if (!IS_ENABLED(CONFIG_GUS_BEACON_TX_POWER_CTRL)) {
+		return 0;
+	}
+
+	atomic_inc(&beacons);
+	// the previous beacon may still be waiting for its restore
+	k_work_cancel_delayable(&restore_work);
+	return set_adv_power(CONFIG_GUS_BEACON_TX_POWER + calibration);
+}
+
+void tx_power_beacon_end(void)
+{
+	if (!IS_ENABLED(CONFIG_GUS_BEACON_TX_POWER_CTRL)) {
 		return;
 	}
 
-	rp = (void *)rsp->data;
-	printk("Actual Tx Power: %d\n", rp->selected_tx_power);
+	// the last beacon out restores, from the system work queue
+	if (atomic_dec(&beacons) == 1) {
+		k_work_reschedule(&restore_work, K_NO_WAIT);
+	}
+}
 
-	net_buf_unref(rsp);
+int tx_power_calibration_set(int8_t offset)
+{
+	if (offset < -TX_POWER_CALIBRATION_MAX ||
+	    offset > TX_POWER_CALIBRATION_MAX) {
+		return -EINVAL;
+	}
+
+	calibration = offset;
+
+	if (!IS_ENABLED(CONFIG_SETTINGS)) {
+		return 0;
+	}
+
+	return settings_save_one("gus/tx/cal", &calibration,
+				 sizeof(calibration));
+}
+
+int8_t tx_power_calibration_get(void)
+{
+	return calibration;
 }
@@ -6,20 +6,77 @@
 
 /**
  * @file
- * @brief Gus Model handler
+ * @brief Gus TX power manager
  */
 
 #ifndef TX_POWER_H__
 #define TX_POWER_H__
 
+#include <zephyr/types.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void set_tx_power(uint8_t handle_type, uint16_t handle, int8_t tx_pwr_lvl);
+/** Largest calibration offset, in dB either way. */
+#define TX_POWER_CALIBRATION_MAX 20
+
+/** @brief Queue a TX power change.
+ *
+ *  The vendor specific HCI command is built and sent from the system work
+ *  queue without waiting for its response, so this never blocks.
+ *
+ *  @param handle_type BT_HCI_VS_LL_HANDLE_TYPE_ADV or _CONN.
+ *  @param handle      Advertising set or connection handle.
+ *  @param tx_pwr_lvl  TX power in dBm, the controller picks the closest
+ *                     supported level.
+ *
+ *  @retval 0       The command is queued.
+ *  @retval -ENOMEM The command queue is full.
+ */
+int set_tx_power(uint8_t handle_type, uint16_t handle, int8_t tx_pwr_lvl);
+
+/** @brief Lower the advertising TX power for a proximity beacon.
+ *
+ *  Must be called from the system work queue right before the beacon is
+ *  handed to the mesh stack.  Queued power changes and then the beacon
+ *  power are handed to the HCI command queue before this returns, so they
+ *  reach the controller ahead of the beacon's advertising.  May wait for
+ *  an HCI command buffer.
+ *
+ *  @retval 0 The power change is sent.
+ *            Otherwise, a (negative) error code is returned, and the beacon
+ *            would go out at the mesh TX power.
+ */
+int tx_power_beacon_begin(void);
+
+/** @brief Restore the mesh TX power once the beacon has been transmitted.
+ *
+ *  Call once for every tx_power_beacon_begin(), from the send end callback
+ *  of the beacon, or right away if it could not be sent.  The power is
+ *  restored when no other beacon is waiting to be sent.
+ */
+void tx_power_beacon_end(void);
+
+/** @brief Set the calibration offset of this badge.
+ *
+ *  The offset is added to the beacon TX power to even out the differences
+ *  between badges (antenna, enclosure), and is stored in flash.  Set with
+ *  the "gus txcal" shell command.
+ *
+ *  @param offset Offset in dB, up to TX_POWER_CALIBRATION_MAX either way.
+ *
+ *  @retval 0 If the operation was successful.
+ *  @retval -EINVAL The offset is out of range.
+ *            Otherwise, a (negative) error code is returned.
+ */
+int tx_power_calibration_set(int8_t offset);
+
+/** @brief Get the calibration offset of this badge, in dB. */
+int8_t tx_power_calibration_get(void);
 
 #ifdef __cplusplus
 }
 #endif
 
-#endif /* GUS_MODEL_HANDLER_H__ */
+#endif /* TX_POWER_H__ */
@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2020 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+#
+# Decode the binary record stream of a badge built with CONFIG_GUS_STREAM
+# (see src/gus_stream.h) into NDJSON, or CSV with --csv, one line per
+# record and one CSV line per report entry.
+#
+#   JLinkRTTLogger -Device NRF52832_XXAA -If SWD -Speed 4000 \
+#       -RTTChannel 1 room.bin
+#   tools/gus_stream.py room.bin > room.ndjson
+#   tools/gus_stream.py --csv room.bin
+#
+# Anything between the frames that does not decode is skipped.  A gap in the
+# sequence numbers is reported on stderr, with the number of records lost.
+
+import argparse
+import csv
+import json
+import struct
+import sys
+
+SIGN_IN, REPORT, STATE, STATUS, TIMEOUT = range(1, 6)
+TYPE_NAMES = {SIGN_IN: "sign_in", REPORT: "report", STATE: "state",
+              STATUS: "status", TIMEOUT: "timeout"}
+HEADER = struct.Struct("<BHI")
+CSV_FIELDS = ["seq", "time_ms", "type", "addr", "peer", "rssi",
+              "confidence", "state", "name", "name_hash", "neighbors",
+              "contacts"]
+
+
+def crc16_ccitt_false(data):
+    crc = 0xffff
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xffff
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xff and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_record(rec):
+    if len(rec) < HEADER.size + 2:
+        return None
+    body, crc = rec[:-2], struct.unpack_from("<H", rec, len(rec) - 2)[0]
+    if crc16_ccitt_false(body) != crc:
+        return None
+
+    rtype, seq, time_ms = HEADER.unpack_from(body)
+    body = body[HEADER.size:]
+    out = {"seq": seq, "time_ms": time_ms,
+           "type": TYPE_NAMES.get(rtype, rtype)}
+
+    try:
+        if rtype == SIGN_IN:
+            out["addr"] = struct.unpack_from("<H", body)[0]
+            out["name"] = body[2:].decode("utf-8", "replace")
+        elif rtype == REPORT:
+            out["addr"], count = struct.unpack_from("<HB", body)
+            out["contacts"] = [
+                dict(zip(("peer", "rssi", "confidence"),
+                         struct.unpack_from("<HbB", body, 3 + 4 * i)))
+                for i in range(count)]
+        elif rtype == STATE:
+            out["addr"], out["state"] = struct.unpack_from("<HB", body)
+        elif rtype == STATUS:
+            (out["addr"], out["state"], out["name_hash"], out["neighbors"],
+             out["contacts"]) = struct.unpack_from("<HBHBB", body)
+        elif rtype == TIMEOUT:
+            out["addr"] = struct.unpack_from("<H", body)[0]
+    except struct.error:
+        return None
+
+    return out
+
+
+def frames(stream):
+    buf = bytearray()
+    while True:
+        chunk = stream.read1(4096) if hasattr(stream, "read1") \
+            else stream.read(4096)
+        if not chunk:
+            return
+        buf += chunk
+        *complete, buf = buf.split(b"\0")
+        buf = bytearray(buf)
+        for frame in complete:
+            if frame:
+                yield bytes(frame)
+
+
+def csv_rows(rec):
+    if rec["type"] == "report":
+        for contact in rec["contacts"] or [{}]:
+            row = dict(rec, contacts=len(rec["contacts"]))
+            row.update(contact)
+            yield row
+    else:
+        yield rec
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decode the Gus badge record stream.")
+    parser.add_argument("input", nargs="?", default="-",
+                        help="RTT capture, serial device or file, - for stdin")
+    parser.add_argument("--csv", action="store_true", help="write CSV")
+    args = parser.parse_args()
+
+    stream = sys.stdin.buffer if args.input == "-" else \
+        open(args.input, "rb", buffering=0)
+
+    writer = None
+    if args.csv:
+        writer = csv.DictWriter(sys.stdout, CSV_FIELDS, extrasaction="ignore")
+        writer.writeheader()
+
+    expected = None
+    for frame in frames(stream):
+        rec = cobs_decode(frame)
+        rec = decode_record(rec) if rec else None
+        if rec is None:
+            continue
+
+        if expected is not None and rec["seq"] != expected:
+            lost = (rec["seq"] - expected) & 0xffff
+            if lost < 0x8000:
+                print(f"gus_stream: {lost} records lost before seq "
+                      f"{rec['seq']}", file=sys.stderr)
+            else:
+                print(f"gus_stream: sequence restarted at {rec['seq']}",
+                      file=sys.stderr)
+        expected = (rec["seq"] + 1) & 0xffff
+
+        if writer:
+            for row in csv_rows(rec):
+                writer.writerow(row)
+        else:
+            print(json.dumps(rec))
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()